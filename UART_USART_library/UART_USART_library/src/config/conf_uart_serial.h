@@ -68,4 +68,17 @@
 /** Stop bits setting */
 //#define CONF_UART_STOP_BITS    US_MR_NBSTOP_1_BIT
 
+/* Serial middleware buffers, one line per interface in uart0..uart4, usart0..usart2 order */
+/* Interface, RX size (bytes), TX size (bytes), timestamp queue depth (frames), all powers of two */
+/* Depth 0 when the interface is never initialized with TIMESTAMP_USED : no frame descriptor is reserved */
+#define SERIAL_MDW_CONF_BUFFERS(BUFFER)       \
+	BUFFER(uart0,   256,    256,    32)       \
+	BUFFER(uart1,   256,    256,    32)       \
+	BUFFER(uart2,   256,    256,    32)       \
+	BUFFER(uart3,   256,    256,    32)       \
+	BUFFER(uart4,   256,    256,    32)       \
+	BUFFER(usart0,  256,    256,    32)       \
+	BUFFER(usart1,  256,    256,    32)       \
+	BUFFER(usart2,  256,    256,    32)
+
 #endif/* CONF_USART_SERIAL_H_INCLUDED */
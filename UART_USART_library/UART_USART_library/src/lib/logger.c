@@ -1,8 +1,237 @@
 #include "logger.h"
+#include "timebase.h"
+
+_Static_assert((LOGGER_DEFERRED_RECORDS & (LOGGER_DEFERRED_RECORDS - 1)) == 0 && LOGGER_DEFERRED_RECORDS >= 2,
+	"LOGGER_DEFERRED_RECORDS must be a power of two");
+_Static_assert(LOG_TRACE == 0 && LOG_FATAL == 5, "LOG_COMPILE_LEVEL compares numbers with log_level_t");
+_Static_assert(LOGGER_DUMP_CHUNK_LENGTH >= 8 && LOGGER_DUMP_CHUNK_LENGTH <= LOGGER_RECORD_ARGS_SIZE, "a part of a dump is stored whole in a record");
+_Static_assert(LOGGER_RECORD_ARGS_SIZE <= 255, "length of the arguments is kept on 8 bits");
+_Static_assert(LOGGER_SINK_BATCH_SIZE > LOGGER_MESSAGE_MAX_LENGTH && LOGGER_SINK_BATCH_SIZE >= LOGGER_WIRE_MAX_SIZE,
+	"a line or a record fits in a batch");
+_Static_assert((LOGGER_RAM_RING_SIZE & (LOGGER_RAM_RING_SIZE - 1)) == 0, "LOGGER_RAM_RING_SIZE must be a power of two");
+
+// Slot of the ring : sequence is the lap of the slot (position & ~mask) when it is free and the lap + 1 once its record is written,
+// all zero is an empty ring : records can be stored before logger_init
+typedef struct logger_slot_t {
+	volatile uint32_t	sequence;
+	log_record_t		record;
+} logger_slot_t;
+
+// Sink and the lines waiting for it in logger_process
+typedef struct logger_sink_slot_t {
+	logger_sink_write_t	write;
+	void				*context;
+	log_level_t			level;
+	uint32_t			batch_length;
+	uint8_t				batch[LOGGER_SINK_BATCH_SIZE];
+} logger_sink_slot_t;
+
+// Post-mortem ring : head counts the bytes ever written, magic tells the content survived the reset
+#define LOGGER_RAM_RING_MAGIC	0x4C4F4752u
+typedef struct logger_ram_ring_t {
+	uint32_t	magic;
+	uint32_t	head;
+	uint8_t		data[LOGGER_RAM_RING_SIZE];
+} logger_ram_ring_t;
+
+#if defined(TEST)
+#	define LOGGER_NOINIT
+#else
+#	define LOGGER_NOINIT __attribute__((section(".noinit")))
+#endif
+
+// Post-mortem ring is written from the log call in any context : interrupts are masked while it is updated
+#if defined(TEST)
+#	define LOGGER_LOCK()			(0)
+#	define LOGGER_UNLOCK(flags)		((void)(flags))
+#else
+#	define LOGGER_LOCK()			cpu_irq_save()
+#	define LOGGER_UNLOCK(flags)		cpu_irq_restore(flags)
+#endif
 
 static log_level_t logger_log_level = LOG_DEBUG;
-static const char *level_names[] = {
-	"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+#if defined(SERIAL_LOG)
+static serial_mdw_handle_t logger_serial_handle = SERIAL_MDW_HANDLE_INVALID;
+#endif
+
+// Console is written without logger_init, as printf did
+static logger_sink_slot_t logger_sinks[LOGGER_MAX_SINKS] = {
+#if defined(CONSOLE_LOG)
+	{.write = logger_sink_stdout, .context = NULL, .level = LOG_TRACE},
+#endif
+};
+static logger_ram_ring_t logger_ram_ring LOGGER_NOINIT;
+
+// Many writers (main loop and interrupts) reserve slots by moving the head, logger_process is the only reader
+static logger_slot_t logger_ring[LOGGER_DEFERRED_RECORDS];
+static volatile uint32_t logger_ring_head = 0;
+static uint32_t logger_ring_tail = 0;
+static volatile uint32_t logger_ring_dropped = 0;
+static uint32_t logger_ring_dropped_reported = 0;
+
+#define LOGGER_RING_MASK	(LOGGER_DEFERRED_RECORDS - 1)
+#define LOGGER_RING_LAP(x)	((x) & ~(uint32_t)LOGGER_RING_MASK)
+
+/*
+   ---------------------------------------
+   --------- Internal functions ----------
+   ---------------------------------------
+*/
+
+// Append an argument to a record, nothing more is stored once one doesn't fit
+static void logger_store_arg(uint8_t *args, uint32_t *length, const void *value, uint32_t size, uint8_t *truncated)
+{
+	if(*truncated || *length + size > LOGGER_RECORD_ARGS_SIZE)
+	{
+		*truncated = 1;
+		return;
+	}
+	memcpy(&args[*length], value, size);
+	*length += size;
+}
+
+// Copy the arguments of a call into a record, in the order of the conversions
+static uint32_t logger_capture_args(uint8_t *args, const char *fmt, va_list *ap, uint8_t *truncated)
+{
+	uint32_t length = 0;
+	logger_arg_t type;
+	uint8_t stars;
+
+	*truncated = 0;
+	while(*fmt != '\0')
+	{
+		if(*fmt++ != '%') continue;
+		if(*fmt == '%')
+		{
+			fmt++;
+			continue;
+		}
+		fmt = logger_parse_conversion(fmt, &type, &stars);
+
+		// Arguments are still taken from the list once the record is full, so that the following ones stay in order
+		for(; stars != 0; stars--)
+		{
+			int32_t value = va_arg(*ap, int);
+			logger_store_arg(args, &length, &value, sizeof(value), truncated);
+		}
+		switch(type)
+		{
+			case LOGGER_ARG_INT:
+			case LOGGER_ARG_LONG:
+			case LOGGER_ARG_SIZE:
+			case LOGGER_ARG_POINTER:
+			{
+				uint32_t value;
+				if(type == LOGGER_ARG_INT) value = (uint32_t)va_arg(*ap, int);
+				else if(type == LOGGER_ARG_LONG) value = (uint32_t)va_arg(*ap, long);
+				else if(type == LOGGER_ARG_SIZE) value = (uint32_t)va_arg(*ap, size_t);
+				else value = (uint32_t)(uintptr_t)va_arg(*ap, void *);
+				logger_store_arg(args, &length, &value, sizeof(value), truncated);
+				break;
+			}
+			case LOGGER_ARG_LONG_LONG:
+			{
+				uint64_t value = (uint64_t)va_arg(*ap, long long);
+				logger_store_arg(args, &length, &value, sizeof(value), truncated);
+				break;
+			}
+			case LOGGER_ARG_DOUBLE:
+			{
+				double value = va_arg(*ap, double);
+				logger_store_arg(args, &length, &value, sizeof(value), truncated);
+				break;
+			}
+			case LOGGER_ARG_STRING:
+			{
+				const char *value = va_arg(*ap, const char *);
+				uint32_t string_length;
+				if(value == NULL) value = "(null)";
+				string_length = strnlen(value, LOGGER_RECORD_ARGS_SIZE);
+				// A string which doesn't fit is cut, it is the last argument kept
+				if(!*truncated && length < LOGGER_RECORD_ARGS_SIZE)
+				{
+					if(length + string_length + 1 > LOGGER_RECORD_ARGS_SIZE)
+					{
+						string_length = LOGGER_RECORD_ARGS_SIZE - length - 1;
+						*truncated = 1;
+					}
+					memcpy(&args[length], value, string_length);
+					args[length + string_length] = '\0';
+					length += string_length + 1;
+				}else
+				{
+					*truncated = 1;
+				}
+				break;
+			}
+			default:
+				// %n isn't written
+				if(*(fmt - 1) == 'n') (void)va_arg(*ap, void *);
+				break;
+		}
+	}
+
+	return length;
+}
+
+// Write a line to every sink at its level, from the log call
+static void logger_write(log_level_t level, const char *buffer, int length)
+{
+	char line[LOGGER_MESSAGE_MAX_LENGTH + 1];
+
+	if(length <= 0) return;
+	// Last byte of a truncated message is its '\0'
+	if(length > LOGGER_MESSAGE_MAX_LENGTH - 1) length = LOGGER_MESSAGE_MAX_LENGTH - 1;
+	memcpy(line, buffer, length);
+	if(line[length - 1] != '\n') line[length++] = '\n';
+
+	for(uint8_t i = 0; i < LOGGER_MAX_SINKS; i++)
+	{
+		logger_sink_slot_t *sink = &logger_sinks[i];
+
+		if(sink->write != NULL && level >= sink->level) sink->write((const uint8_t *)line, (uint32_t)length, sink->context);
+	}
+}
+
+static void logger_batch_flush(logger_sink_slot_t *sink)
+{
+	if(sink->batch_length == 0) return;
+	sink->write(sink->batch, sink->batch_length, sink->context);
+	sink->batch_length = 0;
+}
+
+// Add a line (or a binary record) to the batch of every sink at its level, a full batch is written first
+static void logger_batch(log_level_t level, const uint8_t *data, uint32_t length, uint8_t end_line)
+{
+	if(end_line && length != 0 && data[length - 1] == '\n') end_line = 0;
+
+	for(uint8_t i = 0; i < LOGGER_MAX_SINKS; i++)
+	{
+		logger_sink_slot_t *sink = &logger_sinks[i];
+
+		if(sink->write == NULL || level < sink->level) continue;
+		if(sink->batch_length + length + end_line > LOGGER_SINK_BATCH_SIZE) logger_batch_flush(sink);
+		memcpy(&sink->batch[sink->batch_length], data, length);
+		sink->batch_length += length;
+		if(end_line) sink->batch[sink->batch_length++] = '\n';
+	}
+}
+
+static uint8_t *logger_put_le(uint8_t *buffer, uint32_t value, uint8_t size)
+{
+	while(size--)
+	{
+		*buffer++ = (uint8_t)value;
+		value >>= 8;
+	}
+	return buffer;
+}
+
+/*
+   ---------------------------------------
+   -------- Functions definition ---------
+   ---------------------------------------
+*/
 
 void logger_init(log_level_t log_level)
 {
@@ -14,7 +243,8 @@ void logger_init(log_level_t log_level)
             .paritytype = US_MR_PAR_NO,
             .stopbits = US_MR_NBSTOP_1_BIT
         };
-        serial_mdw_init_interface(SERIAL_LOG_ID, &serial_option, TIMESTAMP_USED);
+        serial_mdw_init_interface((usart_if)SERIAL_LOG_ID, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &logger_serial_handle);
+        logger_add_sink(logger_sink_serial, &logger_serial_handle, LOG_TRACE);
     #endif
 }
 
@@ -23,27 +253,121 @@ void logger_set_log_level(log_level_t log_level)
 	logger_log_level = log_level;
 }
 
-char * log_buffer(uint8_t *p_buff, uint8_t buffer_length)
+int8_t logger_add_sink(logger_sink_write_t write, void *context, log_level_t level)
 {
-	uint8_t length = 0;
-    char *buffer = (char*) malloc(LOGGER_MESSAGE_MAX_LENGTH * sizeof(char));
+	int8_t free_sink = -1;
 
-    length += snprintf(buffer + length, LOGGER_MESSAGE_MAX_LENGTH, "<");
-
-    for(uint8_t i=0; i<buffer_length; i++){
-        length += snprintf(buffer + length, LOGGER_MESSAGE_MAX_LENGTH, "%u:", *p_buff);
-		p_buff++;
+	for(int8_t i = 0; i < LOGGER_MAX_SINKS; i++)
+	{
+		if(logger_sinks[i].write == write && logger_sinks[i].context == context)
+		{
+			logger_sinks[i].level = level;
+			return i;
+		}
+		if(logger_sinks[i].write == NULL && free_sink < 0) free_sink = i;
 	}
-	if(buffer_length > 0)
+	if(free_sink < 0) return -1;
+
+	logger_sinks[free_sink].context = context;
+	logger_sinks[free_sink].level = level;
+	logger_sinks[free_sink].batch_length = 0;
+	// Published last : the sink is complete when a log call running in an interrupt sees it
+	__atomic_store_n(&logger_sinks[free_sink].write, write, __ATOMIC_RELEASE);
+
+	return free_sink;
+}
+
+void logger_set_sink_level(int8_t sink, log_level_t level)
+{
+	if(sink >= 0 && sink < LOGGER_MAX_SINKS) logger_sinks[sink].level = level;
+}
+
+void logger_remove_sink(int8_t sink)
+{
+	if(sink < 0 || sink >= LOGGER_MAX_SINKS || logger_sinks[sink].write == NULL) return;
+
+	// Lines already given to logger_process are not lost
+	logger_batch_flush(&logger_sinks[sink]);
+	__atomic_store_n(&logger_sinks[sink].write, NULL, __ATOMIC_RELEASE);
+}
+
+void logger_sink_stdout(const uint8_t *data, uint32_t length, void *context)
+{
+	(void)context;
+	fwrite(data, 1, length, stdout);
+}
+
+#if defined(SERIAL_LOG)
+void logger_sink_serial(const uint8_t *data, uint32_t length, void *context)
+{
+	serial_mdw_send_bytes(*(serial_mdw_handle_t *)context, data, length);
+	delay_ms(DELAY_TO_PRINT);
+}
+#endif
+
+void logger_sink_ram_ring(const uint8_t *data, uint32_t length, void *context)
+{
+	uint32_t head;
+	uint32_t flags;
+
+	(void)context;
+	flags = LOGGER_LOCK();
+	// RAM is random after a power-on
+	if(logger_ram_ring.magic != LOGGER_RAM_RING_MAGIC) logger_ram_ring_clear();
+
+	// Only the end of a write longer than the ring is kept
+	if(length > LOGGER_RAM_RING_SIZE)
 	{
-		length += snprintf(buffer + length, LOGGER_MESSAGE_MAX_LENGTH, "\b>");
-	}else
+		logger_ram_ring.head += length - LOGGER_RAM_RING_SIZE;
+		data += length - LOGGER_RAM_RING_SIZE;
+		length = LOGGER_RAM_RING_SIZE;
+	}
+	head = logger_ram_ring.head;
+	for(uint32_t i = 0; i < length; i++) logger_ram_ring.data[(head + i) & (LOGGER_RAM_RING_SIZE - 1)] = data[i];
+	logger_ram_ring.head = head + length;
+	LOGGER_UNLOCK(flags);
+}
+
+uint32_t logger_ram_ring_read(uint8_t *buffer, uint32_t size)
+{
+	uint32_t length;
+	uint32_t start;
+
+	if(logger_ram_ring.magic != LOGGER_RAM_RING_MAGIC) return 0;
+
+	length = (logger_ram_ring.head < LOGGER_RAM_RING_SIZE) ? logger_ram_ring.head : LOGGER_RAM_RING_SIZE;
+	if(length > size) length = size;
+	start = logger_ram_ring.head - length;
+	for(uint32_t i = 0; i < length; i++) buffer[i] = logger_ram_ring.data[(start + i) & (LOGGER_RAM_RING_SIZE - 1)];
+
+	return length;
+}
+
+void logger_ram_ring_clear(void)
+{
+	logger_ram_ring.head = 0;
+	logger_ram_ring.magic = LOGGER_RAM_RING_MAGIC;
+}
+
+void log_dump(log_level_t level, const char *file, uint32_t line, const char *prefix, const uint8_t *data, uint32_t length, uint8_t base)
+{
+	char chunk[LOGGER_DUMP_CHUNK_LENGTH];
+	size_t offset = 0;
+	size_t used = 0;
+
+	if (level < logger_log_level) return;
+
+	// Prefix shares the first line, with room left for the first byte
+	if(prefix != NULL)
 	{
-		length += snprintf(buffer + length, LOGGER_MESSAGE_MAX_LENGTH, ">");
+		used = strnlen(prefix, sizeof(chunk) - 7);
+		memcpy(chunk, prefix, used);
 	}
-	
-	
-	return buffer;
+	do {
+		logger_dump(&chunk[used], sizeof(chunk) - used, data, length, &offset, base);
+		LOGGER_CALL(level, file, line, "%s\r\n", chunk);
+		used = 0;
+	} while(offset < length);
 }
 
 void log_log(log_level_t level, const char *file, uint32_t line, const char *fmt, ...)
@@ -61,7 +385,7 @@ void log_log(log_level_t level, const char *file, uint32_t line, const char *fmt
 		#if defined(ADVANCED_LOG)
 			char output_message[LOGGER_MESSAGE_MAX_LENGTH]={0};
 			int length_advanced_log = 0;
-			length_advanced_log = snprintf(output_message, LOGGER_MESSAGE_MAX_LENGTH, "%-5s %s:%lu: ", level_names[level], file, line,fmt, args);
+			length_advanced_log = snprintf(output_message, LOGGER_MESSAGE_MAX_LENGTH, "%-5s %s:%lu: ", logger_level_name(level), file, line,fmt, args);
 
 			// Protection against length being > LOGGER_MESSAGE_MAX_LENGTH
 			if(	length_advanced_log >= 0 && 
@@ -81,12 +405,162 @@ void log_log(log_level_t level, const char *file, uint32_t line, const char *fmt
 			memcpy(buffer, output_message, length);
 		#endif
 
-        #if defined(SERIAL_LOG)
-			if(length >= 0) serial_mdw_send_bytes(SERIAL_LOG_ID, (uint8_t *)buffer, (uint32_t)length);
-		    delay_ms(DELAY_TO_PRINT);
-		#elif defined(CONSOLE_LOG)
-			printf("%s\n",buffer, length);
-        #endif
+		logger_write(level, buffer, length);
 	}
 	 
+}
+
+void log_record(log_level_t level, const char *file, uint32_t line, const char *fmt, ...)
+{
+	uint32_t head;
+	logger_slot_t *slot;
+	log_record_t *record;
+	va_list args;
+
+	if (level < logger_log_level) return;
+
+	// Slot is reserved by moving the head, another writer interrupting this one takes the next slot
+	head = __atomic_load_n(&logger_ring_head, __ATOMIC_RELAXED);
+	do {
+		int32_t lap;
+
+		slot = &logger_ring[head & LOGGER_RING_MASK];
+		lap = (int32_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - LOGGER_RING_LAP(head));
+		if(lap < 0)
+		{
+			// Slot still holds the record of the previous lap
+			__atomic_fetch_add(&logger_ring_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+		if(lap > 0)
+		{
+			// Slot taken by another writer since the head has been read
+			head = __atomic_load_n(&logger_ring_head, __ATOMIC_RELAXED);
+			continue;
+		}
+		if(__atomic_compare_exchange_n(&logger_ring_head, &head, head + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+	} while(1);
+
+	record = &slot->record;
+	record->timestamp = (uint32_t)timebase_monotonic_us();
+	record->fmt = fmt;
+	record->file = file;
+	record->line = (uint16_t)line;
+	record->level = (uint8_t)level;
+	va_start(args, fmt);
+	record->length = (uint8_t)logger_capture_args(record->args, fmt, &args, &record->truncated);
+	va_end(args);
+
+	__atomic_store_n(&slot->sequence, LOGGER_RING_LAP(head) + 1, __ATOMIC_RELEASE);
+}
+
+uint8_t logger_pop_record(log_record_t *record)
+{
+	logger_slot_t *slot = &logger_ring[logger_ring_tail & LOGGER_RING_MASK];
+
+	if(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != LOGGER_RING_LAP(logger_ring_tail) + 1) return 0;
+
+	*record = slot->record;
+	// Slot is given back for the next lap
+	__atomic_store_n(&slot->sequence, LOGGER_RING_LAP(logger_ring_tail) + LOGGER_DEFERRED_RECORDS, __ATOMIC_RELEASE);
+	logger_ring_tail++;
+
+	return 1;
+}
+
+uint32_t logger_dropped_records(void)
+{
+	return logger_ring_dropped;
+}
+
+int logger_format_record(const log_record_t *record, char *buffer, size_t size)
+{
+	int length = 0;
+
+	#if defined(ADVANCED_LOG)
+		length = snprintf(buffer, size, "%lu %-5s %s:%u: ", (unsigned long)record->timestamp, logger_level_name(record->level), record->file, record->line);
+	#else
+		length = snprintf(buffer, size, "%lu ", (unsigned long)record->timestamp);
+	#endif
+	if(length < 0 || (size_t)length >= size) return (size != 0) ? (int)strlen(buffer) : 0;
+
+	return length + logger_format_args(&buffer[length], size - length, record->fmt, record->args, record->length, record->truncated);
+}
+
+uint32_t logger_encode_record(const log_record_t *record, uint8_t *buffer)
+{
+	uint8_t *p = buffer;
+	uint8_t checksum = 0;
+	uint8_t length = (record->length <= LOGGER_RECORD_ARGS_SIZE) ? record->length : LOGGER_RECORD_ARGS_SIZE;
+
+	*p++ = LOGGER_WIRE_SYNC_0;
+	*p++ = LOGGER_WIRE_SYNC_1;
+	*p++ = length;
+	*p++ = (uint8_t)(record->level | (record->truncated ? LOGGER_WIRE_TRUNCATED : 0));
+	p = logger_put_le(p, record->line, 2);
+	p = logger_put_le(p, record->timestamp, 4);
+	// Addresses of the strings in the firmware, the decoder reads them from the ELF
+	p = logger_put_le(p, (uint32_t)(uintptr_t)record->fmt, 4);
+	p = logger_put_le(p, (uint32_t)(uintptr_t)record->file, 4);
+	memcpy(p, record->args, length);
+	p += length;
+	for(uint8_t *c = &buffer[2]; c < p; c++) checksum ^= *c;
+	*p++ = checksum;
+
+	return (uint32_t)(p - buffer);
+}
+
+uint32_t logger_process(uint32_t max_records)
+{
+	log_record_t record;
+	uint32_t processed = 0;
+	uint32_t dropped = logger_ring_dropped;
+#if defined(LOGGER_BINARY_OUTPUT)
+	uint8_t buffer[LOGGER_WIRE_MAX_SIZE];
+
+	// Records lost since the last call are reported where they are missing, by a record without format
+	if(dropped != logger_ring_dropped_reported)
+	{
+		memset(&record, 0, sizeof(record));
+		record.timestamp = (uint32_t)timebase_monotonic_us();
+		record.level = LOG_WARN;
+		record.length = sizeof(uint32_t);
+		dropped -= logger_ring_dropped_reported;
+		memcpy(record.args, &dropped, sizeof(uint32_t));
+		logger_batch(LOG_WARN, buffer, logger_encode_record(&record, buffer), 0);
+		logger_ring_dropped_reported += dropped;
+	}
+
+	while(processed < max_records && logger_pop_record(&record))
+	{
+		logger_batch((log_level_t)record.level, buffer, logger_encode_record(&record, buffer), 0);
+		processed++;
+	}
+#else
+	char buffer[LOGGER_MESSAGE_MAX_LENGTH];
+	int length;
+
+	// Records lost since the last call are reported where they are missing
+	if(dropped != logger_ring_dropped_reported)
+	{
+		length = snprintf(buffer, sizeof(buffer), "%lu log records dropped", (unsigned long)(dropped - logger_ring_dropped_reported));
+		if(length > 0) logger_batch(LOG_WARN, (const uint8_t *)buffer, (uint32_t)length, 1);
+		logger_ring_dropped_reported = dropped;
+	}
+
+	while(processed < max_records && logger_pop_record(&record))
+	{
+		length = logger_format_record(&record, buffer, sizeof(buffer));
+		logger_batch((log_level_t)record.level, (const uint8_t *)buffer, (uint32_t)length, 1);
+		processed++;
+	}
+#endif
+
+	// Lines of this call are written, one transfer per sink
+	for(uint8_t i = 0; i < LOGGER_MAX_SINKS; i++)
+	{
+		if(logger_sinks[i].write != NULL) logger_batch_flush(&logger_sinks[i]);
+	}
+
+	return processed;
 }
\ No newline at end of file
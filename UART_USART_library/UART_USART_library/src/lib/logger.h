@@ -30,6 +30,8 @@ Based on rxi library: https://github.com/rxi/log.c/
 #	include "../config/conf_board.h"
 #endif
 
+#include "logger_format.h"
+
 #if defined(SERIAL_LOG)
 #   include "serial_mdw.h"
 #   include "delay.h"
@@ -45,6 +47,12 @@ Based on rxi library: https://github.com/rxi/log.c/
 
 typedef enum {LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL} log_level_t;
 
+// Log calls below this level are removed by the preprocessor : no call, no argument evaluated, no string in flash
+// 0 TRACE, 1 DEBUG, 2 INFO, 3 WARN, 4 ERROR, 5 FATAL, 6 removes every call. Calls kept are still filtered by logger_set_log_level
+#if !defined(LOG_COMPILE_LEVEL)
+#	define LOG_COMPILE_LEVEL 0
+#endif
+
 // Define if you want to use a more verbose option
 #define ADVANCED_LOG
 #if defined(TEST)
@@ -53,6 +61,23 @@ typedef enum {LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL} lo
 #  define LOGGER_MESSAGE_MAX_LENGTH 100
 #endif
 
+// Define to store log calls as binary records in a ring, formatted later by logger_process (idle time)
+// Arguments are copied when the log is called, strings (%s) included, and formatted with the same conversions as printf
+//#define LOGGER_DEFERRED
+// Records kept by the ring until logger_process, power of two
+#define LOGGER_DEFERRED_RECORDS 32
+// Text of a dump written per log line by log_dump, prefix included, it fits in the arguments of a record
+#define LOGGER_DUMP_CHUNK_LENGTH LOGGER_RECORD_ARGS_SIZE
+// Define to write records as they are (logger_format.h) instead of text, they are decoded on the host by tools/log_decoder
+//#define LOGGER_BINARY_OUTPUT
+
+// Sinks written at the same time (logger_add_sink)
+#define LOGGER_MAX_SINKS 4
+// Bytes given to a sink in one call by logger_process : many lines in one transfer
+#define LOGGER_SINK_BATCH_SIZE 256
+// Post-mortem ring of the last lines in RAM, kept through a reset (.noinit), power of two
+#define LOGGER_RAM_RING_SIZE 1024
+
 #if defined(SERIAL_LOG)
 // RAPTORS IS UART0
 // SAME70-XPLD is USART1 (use default USB com port)
@@ -60,27 +85,196 @@ typedef enum {LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL} lo
     const static uint8_t	DELAY_TO_PRINT = 0; // This parameter will influence greatly the behavior of the system because of the delay introduced
 #endif
 
+// Record of a deferred log call, the format string and the file have to stay in memory (literals)
+typedef struct log_record_t {
+	uint32_t	timestamp;		// monotonic time of the call in microseconds, low 32 bits (timebase.h)
+	const char	*fmt;
+	const char	*file;
+	uint16_t	line;
+	uint8_t		level;			// log_level_t
+	uint8_t		truncated;		// arguments didn't fit in args
+	uint8_t		length;			// bytes used in args
+	uint8_t		args[LOGGER_RECORD_ARGS_SIZE];
+} log_record_t;
+
+// Write whole lines, each one ended by '\n' (binary records with LOGGER_BINARY_OUTPUT)
+// Called from the log call (log_log, main loop or interrupt) or from logger_process with a batch of lines
+typedef void (*logger_sink_write_t)(const uint8_t *data, uint32_t length, void *context);
+
 /*
    ---------------------------------------
    --------- Debugging functions ---------
    ---------------------------------------
 */
 
-#define log_trace(...) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
-#define log_debug(...) log_log(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define log_info(...)  log_log(LOG_INFO,  __FILE__, __LINE__, __VA_ARGS__)
-#define log_warn(...)  log_log(LOG_WARN,  __FILE__, __LINE__, __VA_ARGS__)
-#define log_error(...) log_log(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define log_fatal(...) log_log(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+#if defined(LOGGER_DEFERRED)
+#	define LOGGER_CALL log_record
+#else
+#	define LOGGER_CALL log_log
+#endif
+
+#if LOG_COMPILE_LEVEL <= 0
+#	define log_trace(...) LOGGER_CALL(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#	define log_trace(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 1
+#	define log_debug(...) LOGGER_CALL(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#	define log_debug(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 2
+#	define log_info(...)  LOGGER_CALL(LOG_INFO,  __FILE__, __LINE__, __VA_ARGS__)
+#else
+#	define log_info(...)  ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 3
+#	define log_warn(...)  LOGGER_CALL(LOG_WARN,  __FILE__, __LINE__, __VA_ARGS__)
+#else
+#	define log_warn(...)  ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 4
+#	define log_error(...) LOGGER_CALL(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#	define log_error(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 5
+#	define log_fatal(...) LOGGER_CALL(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#	define log_fatal(...) ((void)0)
+#endif
+
+// Dump of bytes, base is LOGGER_DUMP_DECIMAL or LOGGER_DUMP_HEX
+#if LOG_COMPILE_LEVEL <= 0
+#	define log_dump_trace(prefix, data, length, base) log_dump(LOG_TRACE, __FILE__, __LINE__, prefix, data, length, base)
+#else
+#	define log_dump_trace(prefix, data, length, base) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 1
+#	define log_dump_debug(prefix, data, length, base) log_dump(LOG_DEBUG, __FILE__, __LINE__, prefix, data, length, base)
+#else
+#	define log_dump_debug(prefix, data, length, base) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= 2
+#	define log_dump_info(prefix, data, length, base)  log_dump(LOG_INFO,  __FILE__, __LINE__, prefix, data, length, base)
+#else
+#	define log_dump_info(prefix, data, length, base)  ((void)0)
+#endif
 
 
 extern void logger_init(log_level_t log_level);
 
 extern void logger_set_log_level(log_level_t log_level);
 
-extern char * log_buffer(uint8_t *p_buff, uint8_t buffer_length);
+/**
+* Add a sink written with the lines at or above its level, from the main loop
+* Calls below logger_set_log_level are filtered before the sinks. With CONSOLE_LOG, stdout is already a sink
+* @param write
+* @param context : given to write
+* @param level : lowest level written to the sink
+* @return sink, its level is updated if it is already there
+*         -1 : LOGGER_MAX_SINKS reached
+*/
+extern int8_t logger_add_sink(logger_sink_write_t write, void *context, log_level_t level);
+
+/**
+* Change the lowest level written to a sink
+* @param sink : given by logger_add_sink
+* @param level
+* @return none
+*/
+extern void logger_set_sink_level(int8_t sink, log_level_t level);
+
+/**
+* Remove a sink, from the main loop
+* @param sink : given by logger_add_sink
+* @return none
+*/
+extern void logger_remove_sink(int8_t sink);
+
+/**
+* Sinks given with logger_add_sink : standard output (host), serial port (context is a serial_mdw_handle_t *)
+* and the post-mortem ring in RAM (no context)
+*/
+extern void logger_sink_stdout(const uint8_t *data, uint32_t length, void *context);
+#if defined(SERIAL_LOG)
+extern void logger_sink_serial(const uint8_t *data, uint32_t length, void *context);
+#endif
+extern void logger_sink_ram_ring(const uint8_t *data, uint32_t length, void *context);
+
+/**
+* Read the post-mortem ring, to be called after a reset before logging again
+* @param buffer
+* @param size : size of buffer
+* @return number of bytes given, the most recent ones, oldest first. 0 if the ring has never been written
+*/
+extern uint32_t logger_ram_ring_read(uint8_t *buffer, uint32_t size);
+
+/**
+* Empty the post-mortem ring
+* @param none
+* @return none
+*/
+extern void logger_ram_ring_clear(void);
+
 
 extern void log_log(log_level_t level, const char *file, uint32_t line, const char *fmt, ...) __attribute__ ((format (gnu_printf, 4, 5)));
 
+/**
+* Log bytes as text (logger_dump) without allocation, a long dump is written in lines of LOGGER_DUMP_CHUNK_LENGTH
+* @param level
+* @param file
+* @param line
+* @param prefix : text before the first byte, can be NULL
+* @param data
+* @param length : bytes of data
+* @param base : LOGGER_DUMP_DECIMAL or LOGGER_DUMP_HEX
+* @return none
+*/
+extern void log_dump(log_level_t level, const char *file, uint32_t line, const char *prefix, const uint8_t *data, uint32_t length, uint8_t base);
+
+/**
+* Store a log call in the ring without formatting it, from the main loop or any interrupt
+* The record is dropped (and counted) when the ring is full
+*/
+extern void log_record(log_level_t level, const char *file, uint32_t line, const char *fmt, ...) __attribute__ ((format (gnu_printf, 4, 5)));
+
+/**
+* Take the oldest record of the ring, single reader
+* @param record : copy of the record
+* @return 1 if a record has been taken, 0 if the ring is empty
+*/
+extern uint8_t logger_pop_record(log_record_t *record);
+
+/**
+* Give the number of records dropped because the ring was full, since logger_init
+*/
+extern uint32_t logger_dropped_records(void);
+
+/**
+* Write a record in its binary form (logger_format.h)
+* @param record : record given by logger_pop_record
+* @param buffer : at least LOGGER_WIRE_MAX_SIZE bytes
+* @return number of bytes written
+*/
+extern uint32_t logger_encode_record(const log_record_t *record, uint8_t *buffer);
+
+/**
+* Format a record as log_log would have written it, preceded by its timestamp
+* @param record : record given by logger_pop_record
+* @param buffer : text, always terminated
+* @param size : size of buffer
+* @return length of the text in buffer
+*/
+extern int logger_format_record(const log_record_t *record, char *buffer, size_t size);
+
+/**
+* Format (or encode with LOGGER_BINARY_OUTPUT) and write the records of the ring, to be called when the application is idle
+* Every sink is given its lines in batches of LOGGER_SINK_BATCH_SIZE
+* @param max_records : most records written by this call
+* @return number of records written
+*/
+extern uint32_t logger_process(uint32_t max_records);
+
 
 #endif /* LOGGER_H_ */
\ No newline at end of file
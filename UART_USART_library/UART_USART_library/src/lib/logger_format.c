@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "logger_format.h"
+
+static const char *level_names[] = {
+	"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+
+// Digits of logger_dump : one nibble, or two decimal digits, per entry
+static const char logger_hex_digits[16] = "0123456789abcdef";
+static const char logger_decimal_pairs[200] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+// Characters really written by snprintf in size bytes
+static size_t logger_clip(int result, size_t size)
+{
+	if(result <= 0) return 0;
+	return ((size_t)result < size) ? (size_t)result : size - 1;
+}
+
+const char *logger_level_name(uint8_t level)
+{
+	return (level < sizeof(level_names) / sizeof(level_names[0])) ? level_names[level] : "?";
+}
+
+// Read the conversion starting after '%', give the argument it takes, the number of '*' and the end of the conversion
+const char *logger_parse_conversion(const char *fmt, logger_arg_t *type, uint8_t *stars)
+{
+	uint8_t longs = 0;
+	uint8_t size = 0;
+
+	*stars = 0;
+	// Flags, width and precision
+	while(*fmt != '\0' && strchr("-+ #0123456789.*'", *fmt) != NULL)
+	{
+		if(*fmt == '*') (*stars)++;
+		fmt++;
+	}
+	// Length modifiers
+	while(*fmt != '\0' && strchr("hlLqjzt", *fmt) != NULL)
+	{
+		if(*fmt == 'l' || *fmt == 'q') longs++;
+		if(*fmt == 'j') longs = 2;
+		if(*fmt == 'z' || *fmt == 't') size = 1;
+		fmt++;
+	}
+
+	switch(*fmt)
+	{
+		case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+			*type = (longs >= 2) ? LOGGER_ARG_LONG_LONG : (longs == 1) ? LOGGER_ARG_LONG : size ? LOGGER_ARG_SIZE : LOGGER_ARG_INT;
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			*type = LOGGER_ARG_DOUBLE;
+			break;
+		case 's':
+			*type = LOGGER_ARG_STRING;
+			break;
+		case 'p':
+			*type = LOGGER_ARG_POINTER;
+			break;
+		case '\0':
+			*type = LOGGER_ARG_NONE;
+			return fmt;
+		default:
+			*type = LOGGER_ARG_NONE;
+			break;
+	}
+
+	return fmt + 1;
+}
+
+int logger_format_args(char *buffer, size_t size, const char *fmt, const uint8_t *args, uint32_t length, uint8_t truncated)
+{
+	size_t written = 0;
+	uint32_t used = 0;
+	char spec[24];
+
+	if(size == 0) return 0;
+
+	while(*fmt != '\0' && written + 1 < size)
+	{
+		const char *start = fmt;
+		logger_arg_t type;
+		uint8_t stars;
+		size_t spec_length = 0;
+		int result = 0;
+
+		if(*fmt != '%' || *(fmt + 1) == '%')
+		{
+			buffer[written++] = *fmt;
+			fmt += (*fmt == '%') ? 2 : 1;
+			continue;
+		}
+		fmt = logger_parse_conversion(fmt + 1, &type, &stars);
+
+		// '*' are replaced by their value, the conversion is then formatted alone
+		for(; start < fmt && spec_length + 12 < sizeof(spec); start++)
+		{
+			if(*start == '*')
+			{
+				int32_t value = 0;
+				if(used + sizeof(value) <= length) memcpy(&value, &args[used], sizeof(value));
+				used += sizeof(value);
+				spec_length += snprintf(&spec[spec_length], sizeof(spec) - spec_length, "%ld", (long)value);
+			}else
+			{
+				spec[spec_length++] = *start;
+			}
+		}
+		spec[spec_length] = '\0';
+
+		switch(type)
+		{
+			case LOGGER_ARG_INT:
+			case LOGGER_ARG_LONG:
+			case LOGGER_ARG_SIZE:
+			case LOGGER_ARG_POINTER:
+			{
+				uint32_t value;
+				char conversion = *(fmt - 1);
+				uint8_t is_signed = (conversion == 'd' || conversion == 'i');
+				if(used + sizeof(value) > length) goto missing;
+				memcpy(&value, &args[used], sizeof(value));
+				used += sizeof(value);
+				if(type == LOGGER_ARG_INT) result = snprintf(&buffer[written], size - written, spec, is_signed ? (int)(int32_t)value : (int)value);
+				else if(type == LOGGER_ARG_LONG) result = snprintf(&buffer[written], size - written, spec, is_signed ? (long)(int32_t)value : (long)value);
+				else if(type == LOGGER_ARG_SIZE) result = snprintf(&buffer[written], size - written, spec, (size_t)value);
+				else result = snprintf(&buffer[written], size - written, spec, (void *)(uintptr_t)value);
+				break;
+			}
+			case LOGGER_ARG_LONG_LONG:
+			{
+				uint64_t value;
+				if(used + sizeof(value) > length) goto missing;
+				memcpy(&value, &args[used], sizeof(value));
+				used += sizeof(value);
+				result = snprintf(&buffer[written], size - written, spec, (long long)value);
+				break;
+			}
+			case LOGGER_ARG_DOUBLE:
+			{
+				double value;
+				if(used + sizeof(value) > length) goto missing;
+				memcpy(&value, &args[used], sizeof(value));
+				used += sizeof(value);
+				result = snprintf(&buffer[written], size - written, spec, value);
+				break;
+			}
+			case LOGGER_ARG_STRING:
+			{
+				const char *value = (const char *)&args[used];
+				size_t value_length;
+				if(used >= length) goto missing;
+				// Arguments may come from the wire : a string without terminator in the record is missing
+				value_length = strnlen(value, length - used);
+				if(value_length == length - used) goto missing;
+				used += value_length + 1;
+				result = snprintf(&buffer[written], size - written, spec, value);
+				// A cut string is the last argument
+				if(used >= length && truncated)
+				{
+					written += logger_clip(result, size - written);
+					goto missing;
+				}
+				break;
+			}
+			default:
+				break;
+		}
+
+		written += logger_clip(result, size - written);
+	}
+	buffer[written] = '\0';
+	return (int)written;
+
+missing:
+	// Arguments which didn't fit in the record
+	written += snprintf(&buffer[written], size - written, "...");
+	if(written >= size) written = size - 1;
+	return (int)written;
+}
+
+size_t logger_dump(char *buffer, size_t size, const uint8_t *data, size_t length, size_t *offset, uint8_t base)
+{
+	char *p = buffer;
+	size_t i = *offset;
+
+	if(size == 0) return 0;
+	// Room left for the text, '\0' excluded
+	size--;
+	if(length == 0 && size >= 2)
+	{
+		*p++ = '<';
+		*p++ = '>';
+	}
+	while(i < length)
+	{
+		uint8_t value = data[i];
+		char digits[3];
+		uint8_t count;
+
+		if(base == LOGGER_DUMP_HEX)
+		{
+			digits[0] = logger_hex_digits[value >> 4];
+			digits[1] = logger_hex_digits[value & 0x0F];
+			count = 2;
+		}else
+		{
+			const char *pair = &logger_decimal_pairs[(value % 100) * 2];
+
+			count = 0;
+			if(value >= 100) digits[count++] = (char)('0' + value / 100);
+			if(value >= 10) digits[count++] = pair[0];
+			digits[count++] = pair[1];
+		}
+
+		// Separator, digits and '>' after the last byte : only whole bytes are written
+		if((size_t)(p - buffer) + 1 + count + (i == length - 1) > size) break;
+		*p++ = (i == 0) ? '<' : ':';
+		memcpy(p, digits, count);
+		p += count;
+		if(++i == length) *p++ = '>';
+	}
+	*p = '\0';
+	*offset = i;
+
+	return (size_t)(p - buffer);
+}
+
@@ -0,0 +1,109 @@
+/*
+							        *******************
+******************************* C HEADER FILE *******************************
+**                           *******************                           **
+**                                                                         **
+** project   : RAPTORS                                                     ** 
+** filename  : logger_format                                               **
+** date      : January 11, 2019                                            **
+** author    : Julien Delvaux                                              **
+** licence   : MIT                                                         **
+**                                                                         **
+*****************************************************************************
+Arguments and binary records of the deferred logger, shared by the firmware and the host decoder (tools/log_decoder).
+No dependency on the target : it is built as is on the host.
+
+*/
+
+
+#ifndef LOGGER_FORMAT_H_
+#define LOGGER_FORMAT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+   ---------------------------------------
+   ----------- Record format -------------
+   ---------------------------------------
+*/
+
+// Bytes of arguments of a record : 4 per integer, pointer and '*', 8 per long long and double, strings with their '\0'
+#define LOGGER_RECORD_ARGS_SIZE 40
+
+// Arguments stored in a record for a conversion
+typedef enum {
+	LOGGER_ARG_NONE,		// %%, %n
+	LOGGER_ARG_INT,			// char, short, int : 4 bytes
+	LOGGER_ARG_LONG,		// long : 4 bytes (size on the target)
+	LOGGER_ARG_LONG_LONG,	// long long, intmax_t : 8 bytes
+	LOGGER_ARG_SIZE,		// size_t, ptrdiff_t : 4 bytes (size on the target)
+	LOGGER_ARG_DOUBLE,		// 8 bytes
+	LOGGER_ARG_POINTER,		// 4 bytes (size on the target)
+	LOGGER_ARG_STRING		// copied with its '\0'
+} logger_arg_t;
+
+// Binary record written by logger_process with LOGGER_BINARY_OUTPUT, little endian :
+// sync (2) | length of args (1) | level, LOGGER_WIRE_TRUNCATED (1) | line (2) | timestamp (4) | format address (4) | file address (4) | args | checksum (1)
+// Checksum is the XOR of every byte after the sync. Format and file are read from the firmware (ELF) by the decoder.
+// A record without format address gives the number of records dropped by the firmware in its 4 bytes of arguments.
+#define LOGGER_WIRE_SYNC_0			0xA5
+#define LOGGER_WIRE_SYNC_1			0x5A
+#define LOGGER_WIRE_TRUNCATED		0x80
+#define LOGGER_WIRE_HEADER_SIZE		18
+#define LOGGER_WIRE_SIZE(args_length)	(LOGGER_WIRE_HEADER_SIZE + (args_length) + 1)
+#define LOGGER_WIRE_MAX_SIZE		LOGGER_WIRE_SIZE(LOGGER_RECORD_ARGS_SIZE)
+
+// Bases of logger_dump
+#define LOGGER_DUMP_DECIMAL			10
+#define LOGGER_DUMP_HEX				16
+
+/*
+   ---------------------------------------
+   -------- Functions declaration --------
+   ---------------------------------------
+*/
+
+/**
+* Give the name of a level (log_level_t)
+* @param level
+* @return name, "?" for an unknown level
+*/
+const char *logger_level_name(uint8_t level);
+
+/**
+* Read the conversion starting after '%'
+* @param fmt : character after '%'
+* @param type : argument taken by the conversion
+* @param stars : number of '*' (int arguments taken before the value)
+* @return character after the conversion
+*/
+const char *logger_parse_conversion(const char *fmt, logger_arg_t *type, uint8_t *stars);
+
+/**
+* Format the arguments of a record with its format string, as snprintf would have done
+* @param buffer : text, always terminated
+* @param size : size of buffer
+* @param fmt : format string of the record
+* @param args : arguments of the record
+* @param length : bytes used in args
+* @param truncated : arguments didn't fit in the record, the text ends with "..." where they are missing
+* @return length of the text in buffer
+*/
+int logger_format_args(char *buffer, size_t size, const char *fmt, const uint8_t *args, uint32_t length, uint8_t truncated);
+
+/**
+* Write bytes as text, "<1:2:255>" in decimal or "<01:02:ff>" in hex, without allocation
+* Only whole bytes are written : a dump longer than buffer is given in parts by calling again
+* with the same offset until it reaches length, following parts start with ':'
+* @param buffer : text, always terminated
+* @param size : size of buffer, 6 bytes are enough to move forward
+* @param data
+* @param length : bytes of data
+* @param offset : first byte to write, moved after the last byte written
+* @param base : LOGGER_DUMP_DECIMAL or LOGGER_DUMP_HEX
+* @return length of the text in buffer
+*/
+size_t logger_dump(char *buffer, size_t size, const uint8_t *data, size_t length, size_t *offset, uint8_t base);
+
+#endif /* LOGGER_FORMAT_H_ */
@@ -0,0 +1,145 @@
+/*
+   +========================================+
+				Includes						
+   +========================================+
+*/
+#include "serial_dma.h"
+
+/*
+   +========================================+
+				Defines						
+   +========================================+
+*/
+
+// Byte transfers from the peripheral (interface 1) to the memory (interface 0)
+#define SERIAL_DMA_RX_CONFIG		(XDMAC_CC_TYPE_PER_TRAN | XDMAC_CC_MBSIZE_SINGLE | XDMAC_CC_DSYNC_PER2MEM	\
+									| XDMAC_CC_CSIZE_CHK_1 | XDMAC_CC_DWIDTH_BYTE | XDMAC_CC_SIF_AHB_IF1			\
+									| XDMAC_CC_DIF_AHB_IF0 | XDMAC_CC_SAM_FIXED_AM | XDMAC_CC_DAM_INCREMENTED_AM)
+// Byte transfers from the memory (interface 0) to the peripheral (interface 1)
+#define SERIAL_DMA_TX_CONFIG		(XDMAC_CC_TYPE_PER_TRAN | XDMAC_CC_MBSIZE_SINGLE | XDMAC_CC_DSYNC_MEM2PER	\
+									| XDMAC_CC_CSIZE_CHK_1 | XDMAC_CC_DWIDTH_BYTE | XDMAC_CC_SIF_AHB_IF0			\
+									| XDMAC_CC_DIF_AHB_IF1 | XDMAC_CC_SAM_INCREMENTED_AM | XDMAC_CC_DAM_FIXED_AM)
+
+/*
+   +========================================+
+				Functions definition						
+   +========================================+
+*/
+void serial_dma_rx_start(Xdmac *p_xdmac, uint32_t channel, uint32_t peripheral_id, volatile const void *p_rhr, uint8_t *p_buffer, uint32_t size, serial_dma_descriptor_t *p_descriptor)
+{
+	XdmacChid *p_channel = &p_xdmac->XDMAC_CHID[channel];
+	
+	// Descriptor pointing to itself : the ring is refilled forever
+	p_descriptor->mbr_nda = (uint32_t)(uintptr_t)p_descriptor;
+	p_descriptor->mbr_ubc = SERIAL_DMA_UBC_UBLEN(size) | SERIAL_DMA_UBC_NVIEW_NDV1 | SERIAL_DMA_UBC_NDE | SERIAL_DMA_UBC_NSEN | SERIAL_DMA_UBC_NDEN;
+	p_descriptor->mbr_sa = (uint32_t)(uintptr_t)p_rhr;
+	p_descriptor->mbr_da = (uint32_t)(uintptr_t)p_buffer;
+	
+	serial_dma_clean_dcache(p_descriptor, sizeof(serial_dma_descriptor_t));
+	
+	// Channel has to be disabled and its status cleared before being configured
+	serial_dma_stop(p_xdmac, channel);
+	(void)p_channel->XDMAC_CIS;
+	
+	p_channel->XDMAC_CC = SERIAL_DMA_RX_CONFIG | XDMAC_CC_PERID(peripheral_id);
+	p_channel->XDMAC_CUBC = 0;
+	p_channel->XDMAC_CBC = 0;
+	p_channel->XDMAC_CDS_MSP = 0;
+	p_channel->XDMAC_CSUS = 0;
+	p_channel->XDMAC_CDUS = 0;
+	p_channel->XDMAC_CNDA = (uint32_t)(uintptr_t)p_descriptor;
+	p_channel->XDMAC_CNDC = XDMAC_CNDC_NDE_DSCR_FETCH_EN | XDMAC_CNDC_NDSUP_SRC_PARAMS_UPDATED
+							| XDMAC_CNDC_NDDUP_DST_PARAMS_UPDATED | XDMAC_CNDC_NDVIEW_NDV1;
+	
+	// End of each lap
+	p_channel->XDMAC_CIE = XDMAC_CIE_BIE;
+	p_xdmac->XDMAC_GIE = (XDMAC_GIE_IE0 << channel);
+	p_xdmac->XDMAC_GE = (XDMAC_GE_EN0 << channel);
+}
+
+void serial_dma_tx_start(Xdmac *p_xdmac, uint32_t channel, uint32_t peripheral_id, volatile void *p_thr, const uint8_t *p_buffer, uint32_t size)
+{
+	XdmacChid *p_channel = &p_xdmac->XDMAC_CHID[channel];
+	
+	serial_dma_clean_dcache(p_buffer, size);
+	(void)p_channel->XDMAC_CIS;
+	
+	p_channel->XDMAC_CSA = (uint32_t)(uintptr_t)p_buffer;
+	p_channel->XDMAC_CDA = (uint32_t)(uintptr_t)p_thr;
+	p_channel->XDMAC_CUBC = XDMAC_CUBC_UBLEN(size);
+	p_channel->XDMAC_CC = SERIAL_DMA_TX_CONFIG | XDMAC_CC_PERID(peripheral_id);
+	p_channel->XDMAC_CNDC = 0;
+	p_channel->XDMAC_CBC = 0;
+	p_channel->XDMAC_CDS_MSP = 0;
+	p_channel->XDMAC_CSUS = 0;
+	p_channel->XDMAC_CDUS = 0;
+	
+	p_channel->XDMAC_CIE = XDMAC_CIE_BIE;
+	p_xdmac->XDMAC_GIE = (XDMAC_GIE_IE0 << channel);
+	p_xdmac->XDMAC_GE = (XDMAC_GE_EN0 << channel);
+}
+
+uint8_t serial_dma_tx_completed(Xdmac *p_xdmac, uint32_t channel)
+{
+	return (p_xdmac->XDMAC_CHID[channel].XDMAC_CIS & XDMAC_CIS_BIS) != 0;
+}
+
+uint8_t serial_dma_rx_wrapped(Xdmac *p_xdmac, uint32_t channel)
+{
+	// Status is cleared by its read
+	return (p_xdmac->XDMAC_CHID[channel].XDMAC_CIS & XDMAC_CIS_BIS) != 0;
+}
+
+uint32_t serial_dma_rx_position(Xdmac *p_xdmac, uint32_t channel, uint32_t size)
+{
+	// CUBC holds the number of bytes remaining in the current microblock
+	uint32_t position = size - p_xdmac->XDMAC_CHID[channel].XDMAC_CUBC;
+	
+	if(position >= size) position = 0;
+	
+	return position;
+}
+
+void serial_dma_stop(Xdmac *p_xdmac, uint32_t channel)
+{
+	p_xdmac->XDMAC_GD = (XDMAC_GD_DI0 << channel);
+}
+
+void serial_dma_invalidate_dcache(const uint8_t *p_buffer, uint32_t size)
+{
+	#if !defined(TEST)
+	uint32_t address = (uint32_t)p_buffer & ~(SERIAL_DMA_CACHE_LINE_SIZE - 1);
+	uint32_t end = (uint32_t)p_buffer + size;
+	
+	__DSB();
+	for(; address < end; address += SERIAL_DMA_CACHE_LINE_SIZE)
+	{
+		// DCIMVAU is at the offset of DCIMVAC (invalidate by address to PoC) in this CMSIS version
+		SCB->DCIMVAU = address;
+	}
+	__DSB();
+	__ISB();
+	#else
+	(void)p_buffer;
+	(void)size;
+	#endif
+}
+
+void serial_dma_clean_dcache(const void *p_buffer, uint32_t size)
+{
+	#if !defined(TEST)
+	uint32_t address = (uint32_t)p_buffer & ~(SERIAL_DMA_CACHE_LINE_SIZE - 1);
+	uint32_t end = (uint32_t)p_buffer + size;
+	
+	__DSB();
+	for(; address < end; address += SERIAL_DMA_CACHE_LINE_SIZE)
+	{
+		SCB->DCCMVAC = address;
+	}
+	__DSB();
+	__ISB();
+	#else
+	(void)p_buffer;
+	(void)size;
+	#endif
+}
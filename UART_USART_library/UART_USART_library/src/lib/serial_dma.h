@@ -0,0 +1,183 @@
+/************************************************************************
+Title:    Serial DMA Library
+Author:   Julien Delvaux
+Software: Atmel Studio 7
+Hardware: SAME70Q21
+License:  GNU General Public License 3
+Usage:    see Doxygen manual
+
+LICENSE:
+	Copyright (C) 2018 Julien Delvaux
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+    
+************************************************************************/
+
+/** 
+ *  @defgroup Serial DMA Library
+ *  @code #include <serial_dma.h> @endcode
+ * 
+ *  @brief XDMAC channel helpers used by the serial middleware.
+ *  Every function takes the XDMAC instance so a RAM register model can be used in tests.
+ *
+ *  @author Julien Delvaux <delvaux.ju@gmail.com>
+ */
+
+#ifndef SERIAL_DMA_H_
+#define SERIAL_DMA_H_
+
+/*
+   +========================================+
+				Includes						
+   +========================================+
+*/
+
+#if defined(TEST)
+#	include <stdint.h>
+#else
+#	include "compiler.h"
+#endif
+
+#include "status_codes.h"
+#include "uart_serial.h"
+
+/*
+   +========================================+
+				Defines						
+   +========================================+
+*/
+
+// Cache line size of the Cortex-M7 : DMA buffers have to be aligned on it
+#define SERIAL_DMA_CACHE_LINE_SIZE	32
+
+// XDMAC hardware interface identifiers (PERID) of the UART/USART
+#define SERIAL_DMA_PERID_USART0_TX	7
+#define SERIAL_DMA_PERID_USART0_RX	8
+#define SERIAL_DMA_PERID_USART1_TX	9
+#define SERIAL_DMA_PERID_USART1_RX	10
+#define SERIAL_DMA_PERID_USART2_TX	11
+#define SERIAL_DMA_PERID_USART2_RX	12
+#define SERIAL_DMA_PERID_UART0_TX	20
+#define SERIAL_DMA_PERID_UART0_RX	21
+#define SERIAL_DMA_PERID_UART1_TX	22
+#define SERIAL_DMA_PERID_UART1_RX	23
+#define SERIAL_DMA_PERID_UART2_TX	24
+#define SERIAL_DMA_PERID_UART2_RX	25
+#define SERIAL_DMA_PERID_UART3_TX	26
+#define SERIAL_DMA_PERID_UART3_RX	27
+#define SERIAL_DMA_PERID_UART4_TX	28
+#define SERIAL_DMA_PERID_UART4_RX	29
+
+// Biggest microblock length of a channel
+#define SERIAL_DMA_MAX_BLOCK_SIZE	0xFFFFFFu
+
+// Microblock control member of a linked list descriptor (not provided by the CMSIS headers)
+#define SERIAL_DMA_UBC_UBLEN(value)	((value) & 0xFFFFFFu)
+#define SERIAL_DMA_UBC_NDE			(0x1u << 24)
+#define SERIAL_DMA_UBC_NSEN			(0x1u << 25)
+#define SERIAL_DMA_UBC_NDEN			(0x1u << 26)
+#define SERIAL_DMA_UBC_NVIEW_NDV1	(0x1u << 27)
+
+/**
+* Linked list descriptor, view 1
+*/
+typedef struct serial_dma_descriptor_t {
+	uint32_t mbr_nda;
+	uint32_t mbr_ubc;
+	uint32_t mbr_sa;
+	uint32_t mbr_da;
+} serial_dma_descriptor_t;
+
+/*
+   +========================================+
+				Functions declaration						
+   +========================================+
+*/
+
+/**
+* Start a never ending peripheral to memory transfer into a ring buffer
+* The descriptor is linked to itself, so the channel restarts at the beginning of the buffer once full
+* It doesn't wait for the reader : the end of block interrupt is enabled to follow its laps (serial_dma_rx_wrapped)
+* @param p_xdmac : XDMAC instance
+* @param channel : XDMAC channel
+* @param peripheral_id : SERIAL_DMA_PERID_xxx_RX
+* @param p_rhr : address of the receive holding register
+* @param p_buffer : ring buffer storage, aligned on SERIAL_DMA_CACHE_LINE_SIZE
+* @param size : ring buffer size
+* @param p_descriptor : descriptor, has to stay valid while the transfer is running
+* @return none
+*/
+void serial_dma_rx_start(Xdmac *p_xdmac, uint32_t channel, uint32_t peripheral_id, volatile const void *p_rhr, uint8_t *p_buffer, uint32_t size, serial_dma_descriptor_t *p_descriptor);
+
+/**
+* Give the position in the ring buffer where the next byte will be written
+* @param p_xdmac : XDMAC instance
+* @param channel : XDMAC channel
+* @param size : ring buffer size
+* @return position, from 0 to size - 1
+*/
+uint32_t serial_dma_rx_position(Xdmac *p_xdmac, uint32_t channel, uint32_t size);
+
+/**
+* Check and clear the end of block status of a reception channel
+* @param p_xdmac : XDMAC instance
+* @param channel : XDMAC channel
+* @return true if the channel has gone back to the beginning of the ring buffer since the last call
+*/
+uint8_t serial_dma_rx_wrapped(Xdmac *p_xdmac, uint32_t channel);
+
+/**
+* Start a memory to peripheral transfer of a single block, end of block interrupt is enabled
+* The buffer is written back from the data cache before the transfer
+* @param p_xdmac : XDMAC instance
+* @param channel : XDMAC channel
+* @param peripheral_id : SERIAL_DMA_PERID_xxx_TX
+* @param p_thr : address of the transmit holding register
+* @param p_buffer : bytes to send, has to stay valid until the end of the transfer
+* @param size : number of bytes, up to SERIAL_DMA_MAX_BLOCK_SIZE
+* @return none
+*/
+void serial_dma_tx_start(Xdmac *p_xdmac, uint32_t channel, uint32_t peripheral_id, volatile void *p_thr, const uint8_t *p_buffer, uint32_t size);
+
+/**
+* Check and clear the end of block status of a channel
+* @param p_xdmac : XDMAC instance
+* @param channel : XDMAC channel
+* @return true if the block has been transferred
+*/
+uint8_t serial_dma_tx_completed(Xdmac *p_xdmac, uint32_t channel);
+
+/**
+* Disable the channel
+* @param p_xdmac : XDMAC instance
+* @param channel : XDMAC channel
+* @return none
+*/
+void serial_dma_stop(Xdmac *p_xdmac, uint32_t channel);
+
+/**
+* Invalidate the data cache lines covering a buffer written by the DMA
+* @param p_buffer : buffer, aligned on SERIAL_DMA_CACHE_LINE_SIZE
+* @param size : size of the buffer
+* @return none
+*/
+void serial_dma_invalidate_dcache(const uint8_t *p_buffer, uint32_t size);
+
+/**
+* Write back to memory the data cache lines covering a buffer read by the DMA
+* @param p_buffer : buffer
+* @param size : size of the buffer
+* @return none
+*/
+void serial_dma_clean_dcache(const void *p_buffer, uint32_t size);
+
+#endif /* SERIAL_DMA_H_ */
@@ -0,0 +1,126 @@
+/*
+   +========================================+
+				Includes
+   +========================================+
+*/
+#include "serial_framing.h"
+
+/*
+   +========================================+
+				Functions definition
+   +========================================+
+*/
+status_code_t serial_framing_init(serial_framing_t *framing, const serial_framing_conf_t *conf)
+{
+	switch(conf->mode)
+	{
+		case SERIAL_FRAMING_DELIMITER:
+			if(conf->delimiter_length == 0 || conf->delimiter_length > SERIAL_FRAMING_MAX_DELIMITER) return ERR_INVALID_ARG;
+			break;
+		case SERIAL_FRAMING_LENGTH:
+			if(conf->length_size != 1 && conf->length_size != 2) return ERR_INVALID_ARG;
+			break;
+		case SERIAL_FRAMING_IDLE:
+			if(conf->idle_bits == 0) return ERR_INVALID_ARG;
+			break;
+		case SERIAL_FRAMING_SLIP:
+		case SERIAL_FRAMING_COBS:
+			break;
+		default:
+			return ERR_INVALID_ARG;
+	}
+
+	framing->conf = *conf;
+	serial_framing_reset(framing);
+
+	return STATUS_OK;
+}
+
+void serial_framing_reset(serial_framing_t *framing)
+{
+	framing->state = 0;
+	framing->remaining = 0;
+}
+
+uint8_t serial_framing_receive(serial_framing_t *framing, uint8_t byte, uint8_t *data)
+{
+	uint8_t result = SERIAL_FRAMING_DATA;
+
+	*data = byte;
+
+	switch(framing->conf.mode)
+	{
+		case SERIAL_FRAMING_DELIMITER:
+			// Matching starts again on a mismatch : delimiters are expected without repeated prefix (CRLF...)
+			if(byte == framing->conf.delimiter[framing->state])
+			{
+				framing->state++;
+			}else
+			{
+				framing->state = (byte == framing->conf.delimiter[0]) ? 1 : 0;
+			}
+			if(framing->state == framing->conf.delimiter_length)
+			{
+				framing->state = 0;
+				result |= SERIAL_FRAMING_END;
+			}
+			break;
+
+		case SERIAL_FRAMING_LENGTH:
+			if(framing->state < framing->conf.length_size)
+			{
+				// Header : payload length, big-endian
+				framing->remaining = (framing->remaining << 8) | byte;
+				framing->state++;
+				if(framing->state < framing->conf.length_size || framing->remaining != 0) break;
+			}else if(--framing->remaining != 0)
+			{
+				break;
+			}
+			serial_framing_reset(framing);
+			result |= SERIAL_FRAMING_END;
+			break;
+
+		case SERIAL_FRAMING_SLIP:
+			if(framing->state)
+			{
+				// Escaped byte, an unknown escape is given as is
+				framing->state = 0;
+				if(byte == SERIAL_FRAMING_SLIP_ESC_END) *data = SERIAL_FRAMING_SLIP_END;
+				else if(byte == SERIAL_FRAMING_SLIP_ESC_ESC) *data = SERIAL_FRAMING_SLIP_ESC;
+			}else if(byte == SERIAL_FRAMING_SLIP_ESC)
+			{
+				framing->state = 1;
+				result = 0;
+			}else if(byte == SERIAL_FRAMING_SLIP_END)
+			{
+				result = SERIAL_FRAMING_END;
+			}
+			break;
+
+		case SERIAL_FRAMING_COBS:
+			if(byte == 0x00)
+			{
+				// Zero of the last code byte isn't part of the payload
+				serial_framing_reset(framing);
+				result = SERIAL_FRAMING_END;
+			}else if(framing->remaining == 0)
+			{
+				// Code byte : zero of the previous code byte is stored now that the frame goes on
+				*data = 0x00;
+				result = framing->state ? SERIAL_FRAMING_DATA : 0;
+				framing->state = (byte != 0xFF);
+				framing->remaining = byte - 1;
+			}else
+			{
+				framing->remaining--;
+			}
+			break;
+
+		case SERIAL_FRAMING_IDLE:
+		default:
+			break;
+	}
+
+	return result;
+}
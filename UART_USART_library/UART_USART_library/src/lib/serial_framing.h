@@ -0,0 +1,122 @@
+/************************************************************************
+Title:    Serial Framing Library
+Author:   Julien Delvaux
+Software: Atmel Studio 7
+Hardware: SAME70Q21
+License:  GNU General Public License 3
+Usage:    see Doxygen manual
+
+LICENSE:
+	Copyright (C) 2018 Julien Delvaux
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+
+************************************************************************/
+
+/**
+ *  @defgroup Serial Framing Library
+ *  @code #include <serial_framing.h> @endcode
+ *
+ *  @brief Byte by byte frame detection used by the serial middleware.
+ *  Every received byte goes through serial_framing_receive, which tells if a byte has to be stored
+ *  and if the frame is complete. SLIP and COBS frames are decoded on the fly.
+ *
+ *  @author Julien Delvaux <delvaux.ju@gmail.com>
+ */
+
+#ifndef SERIAL_FRAMING_H_
+#define SERIAL_FRAMING_H_
+
+/*
+   +========================================+
+				Includes
+   +========================================+
+*/
+
+#if defined(TEST)
+#	include <stdint.h>
+#else
+#	include "compiler.h"
+#endif
+
+#include "status_codes.h"
+
+/*
+   +========================================+
+				Defines
+   +========================================+
+*/
+
+// Longest delimiter of SERIAL_FRAMING_DELIMITER mode
+#define SERIAL_FRAMING_MAX_DELIMITER	4
+
+// SLIP special characters (RFC 1055)
+#define SERIAL_FRAMING_SLIP_END			0xC0
+#define SERIAL_FRAMING_SLIP_ESC			0xDB
+#define SERIAL_FRAMING_SLIP_ESC_END		0xDC
+#define SERIAL_FRAMING_SLIP_ESC_ESC		0xDD
+
+// Result of serial_framing_receive
+#define SERIAL_FRAMING_DATA				0x01	// data has to be stored into the frame
+#define SERIAL_FRAMING_END				0x02	// frame is complete
+
+typedef enum {
+	SERIAL_FRAMING_DELIMITER,	// frame ends with a delimiter of 1 to SERIAL_FRAMING_MAX_DELIMITER bytes (CRLF...), kept in the frame
+	SERIAL_FRAMING_LENGTH,		// frame starts with its payload length (1 or 2 bytes, big-endian), header kept in the frame
+	SERIAL_FRAMING_SLIP,		// SLIP frame, decoded payload is stored
+	SERIAL_FRAMING_COBS,		// COBS frame ended by 0x00, decoded payload is stored
+	SERIAL_FRAMING_IDLE			// frame ends when the line stays idle, see serial_mdw_set_framing
+} serial_framing_mode_t;
+
+typedef struct serial_framing_conf_t {
+	serial_framing_mode_t	mode;
+	uint8_t		delimiter[SERIAL_FRAMING_MAX_DELIMITER];	// DELIMITER mode
+	uint8_t		delimiter_length;							// DELIMITER mode
+	uint8_t		length_size;								// LENGTH mode : 1 or 2
+	uint16_t	idle_bits;									// IDLE mode : silence closing the frame, in bit periods
+} serial_framing_conf_t;
+
+typedef struct serial_framing_t {
+	serial_framing_conf_t	conf;
+	uint8_t		state;			// delimiter bytes matched, length header bytes received, SLIP escape or COBS pending zero
+	uint32_t	remaining;		// LENGTH : payload bytes left, COBS : bytes left before the next code byte
+} serial_framing_t;
+
+/*
+   +========================================+
+				Functions declaration
+   +========================================+
+*/
+
+/**
+* Initialize a framing engine
+* @param framing : framing engine
+* @param conf : framing configuration, copied
+* @return STATUS_OK, ERR_INVALID_ARG if the configuration can't be used
+*/
+status_code_t serial_framing_init(serial_framing_t *framing, const serial_framing_conf_t *conf);
+/**
+* Drop the frame in progress
+* @param framing : framing engine
+* @return none
+*/
+void serial_framing_reset(serial_framing_t *framing);
+/**
+* Give a received byte to the framing engine
+* @param framing : framing engine
+* @param byte : byte received
+* @param data : byte to store when SERIAL_FRAMING_DATA is given back
+* @return SERIAL_FRAMING_DATA and/or SERIAL_FRAMING_END, 0 if nothing has to be done
+*/
+uint8_t serial_framing_receive(serial_framing_t *framing, uint8_t byte, uint8_t *data);
+
+#endif /* SERIAL_FRAMING_H_ */
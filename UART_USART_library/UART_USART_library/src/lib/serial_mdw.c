@@ -4,8 +4,11 @@
    +========================================+
 */
 #include "serial_mdw.h"
+#include "serial_dma.h"
+#include "timebase.h"
 
 #include <stdio.h>
+#include <string.h>
 #include "sysclk.h"
 
 /// @cond 0
@@ -23,6 +26,24 @@ extern "C" {
    +========================================+
 */	
 #define NUMBER_OF_UART 8
+_Static_assert(NUMBER_OF_UART <= 32, "interfaces are given by a 32 bits mask");
+// One XDMAC channel per interface for reception, then one per interface for transmission
+#define SERIAL_MDW_DMA_RX_CHANNEL(uart_pointer)	((uint32_t)(uart_pointer))
+#define SERIAL_MDW_DMA_TX_CHANNEL(uart_pointer)	((uint32_t)(uart_pointer) + NUMBER_OF_UART)
+// Reception errors counted in the statistics, same bits in UART_SR and US_CSR
+#define SERIAL_MDW_UART_ERRORS	(UART_SR_OVRE | UART_SR_FRAME | UART_SR_PARE)
+#define SERIAL_MDW_USART_ERRORS	(US_CSR_OVRE | US_CSR_FRAME | US_CSR_PARE)
+// Interrupts are masked while the reader drops the bytes overwritten by the DMA, or while a DMA TX channel is claimed
+#if defined(TEST)
+#	define SERIAL_MDW_LOCK()			(0)
+#	define SERIAL_MDW_UNLOCK(flags)	((void)(flags))
+#else
+#	define SERIAL_MDW_LOCK()			cpu_irq_save()
+#	define SERIAL_MDW_UNLOCK(flags)	cpu_irq_restore(flags)
+#endif
+// Overrun of the reader by the DMA : bytes received since, the frame in progress is cut, or line idle since, the next frame is whole
+#define SERIAL_MDW_DMA_RX_OVERRUN		1
+#define SERIAL_MDW_DMA_RX_OVERRUN_IDLE	2
 	
 typedef enum {
 	NOT_INITIALIZED,
@@ -43,23 +64,67 @@ typedef enum {
 	USART2_pointer
 } UART_pointer_t;
 
+typedef enum {
+	DMA_TX_IDLE,
+	DMA_TX_RING,
+	DMA_TX_BUFFER
+} UART_dma_tx_state_t;
+
 typedef struct serial_mdw_buffer_t {
 	circ_bbuf_t					buffer_rx;
 	circ_bbuf_t					buffer_tx;
 	UART_status_definition_t	status;
+	UART_dma_t					dma_mode;
+	serial_dma_descriptor_t		dma_rx_descriptor;
+	uint32_t					dma_rx_position;
+	int32_t						dma_rx_laps;		// ends of the ring not seen yet through the position
+	volatile uint8_t			dma_rx_overrun;		// unread bytes overwritten by the DMA, dropped by the reader (SERIAL_MDW_DMA_RX_xxx)
+	volatile UART_dma_tx_state_t	dma_tx_state;
+	uint32_t					dma_tx_length;
+	volatile void				*dma_thr;
+	serial_mdw_tx_callback_t	dma_tx_callback;
+	void						*dma_tx_context;
+	serial_mdw_rx_callback_t	rx_callback;
+	void						*rx_context;
+	uint32_t					rx_watermark;
+	uint32_t					rx_timeout_us;
+	volatile uint32_t			rx_since_us;
+	serial_mdw_stats_t			stats;
+	#if defined(SERIAL_MDW_ISR_COUNTERS)
+	serial_mdw_isr_counters_t	isr_counters;
+	#endif
 	
 	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
 	UART_timestamp_t			timestamp_activated;
-	timestamp_buf_t				timestamp_buff;
-	uint32_t					length_data;
-	uint64_t					timestamp;
+	serial_framing_t			framing;
+	frame_queue_t				frames;
 	#endif
 }serial_mdw_buffer_t;
 	
-typedef struct serial_mdw_uart_id_irq_t {
+typedef struct serial_mdw_buffer_conf_t {
+	uint32_t		rx_size;
+	uint32_t		tx_size;
+	#if defined(SERIAL_MDW_STATIC_BUFFERS)
+	uint8_t			*rx_storage;
+	uint8_t			*tx_storage;
+	#endif
+	
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	uint32_t		timestamp_size;
+	#	if defined(SERIAL_MDW_STATIC_BUFFERS)
+	frame_desc_t	*timestamp_storage;
+	#	endif
+	#endif
+}serial_mdw_buffer_conf_t;
+
+typedef struct serial_mdw_port_t {
+	usart_if	p_usart;
+	uint8_t		type;
 	uint8_t		id;
 	IRQn_Type	irq;
-}serial_mdw_uart_id_irq_t;
+	uint8_t		dma_rx_id;
+	uint8_t		dma_tx_id;
+}serial_mdw_port_t;
 
 /*
    +========================================+
@@ -67,17 +132,74 @@ typedef struct serial_mdw_uart_id_irq_t {
    +========================================+
 */
 
-serial_mdw_uart_id_irq_t serial_mdw_uart_id_irq[NUMBER_OF_UART] = {
-	{.id = 	ID_UART0,	.irq = UART0_IRQn},
-	{.id = 	ID_UART1,	.irq = UART1_IRQn},
-	{.id = 	ID_UART2,	.irq = UART2_IRQn},
-	{.id = 	ID_UART3,	.irq = UART3_IRQn},
-	{.id = 	ID_UART4,	.irq = UART4_IRQn},
-	{.id = 	ID_USART0,	.irq = USART0_IRQn},
-	{.id = 	ID_USART1,	.irq = USART1_IRQn},
-	{.id = 	ID_USART2,	.irq = USART2_IRQn}
+const serial_mdw_port_t serial_mdw_port[NUMBER_OF_UART] = {
+	{.p_usart = (usart_if)UART0,		.type = SERIAL_MDW_UART,		.id = ID_UART0,	.irq = UART0_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_UART0_RX,	.dma_tx_id = SERIAL_DMA_PERID_UART0_TX},
+	{.p_usart = (usart_if)UART1,		.type = SERIAL_MDW_UART,		.id = ID_UART1,	.irq = UART1_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_UART1_RX,	.dma_tx_id = SERIAL_DMA_PERID_UART1_TX},
+	{.p_usart = (usart_if)UART2,		.type = SERIAL_MDW_UART,		.id = ID_UART2,	.irq = UART2_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_UART2_RX,	.dma_tx_id = SERIAL_DMA_PERID_UART2_TX},
+	{.p_usart = (usart_if)UART3,		.type = SERIAL_MDW_UART,		.id = ID_UART3,	.irq = UART3_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_UART3_RX,	.dma_tx_id = SERIAL_DMA_PERID_UART3_TX},
+	{.p_usart = (usart_if)UART4,		.type = SERIAL_MDW_UART,		.id = ID_UART4,	.irq = UART4_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_UART4_RX,	.dma_tx_id = SERIAL_DMA_PERID_UART4_TX},
+	{.p_usart = (usart_if)USART0,	.type = SERIAL_MDW_USART,	.id = ID_USART0,	.irq = USART0_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_USART0_RX,	.dma_tx_id = SERIAL_DMA_PERID_USART0_TX},
+	{.p_usart = (usart_if)USART1,	.type = SERIAL_MDW_USART,	.id = ID_USART1,	.irq = USART1_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_USART1_RX,	.dma_tx_id = SERIAL_DMA_PERID_USART1_TX},
+	{.p_usart = (usart_if)USART2,	.type = SERIAL_MDW_USART,	.id = ID_USART2,	.irq = USART2_IRQn,	.dma_rx_id = SERIAL_DMA_PERID_USART2_RX,	.dma_tx_id = SERIAL_DMA_PERID_USART2_TX}
 };
 serial_mdw_buffer_t serial_mdw_buffer[NUMBER_OF_UART] = {0};
+// Interfaces notified since the last serial_mdw_take_rx_events, set from the interrupts
+static volatile uint32_t serial_mdw_rx_events = 0;
+// Interfaces having data to be read, set from the interrupts and cleared by the reader once it is empty
+static volatile uint32_t serial_mdw_ready = 0;
+// Interfaces receiving by DMA without receiver time-out (UARTs), their bytes are published when the reader asks for them
+static uint32_t serial_mdw_dma_rx_polled = 0;
+// Interfaces having data below their watermark, waiting for its time-out
+static volatile uint32_t serial_mdw_rx_waiting = 0;
+// Last interface given by serial_mdw_next_ready
+static uint8_t serial_mdw_ready_last = NUMBER_OF_UART - 1;
+
+// Buffers storage and sizes, generated from SERIAL_MDW_CONF_BUFFERS
+#if defined(SERIAL_MDW_STATIC_BUFFERS)
+#	ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+// Depth 0 : interface never timestamped, the array has no element (GNU C) and takes no RAM
+#		define SERIAL_MDW_TIMESTAMP_STORAGE(port, size)	static frame_desc_t port##_timestamp_storage[size];
+#		define SERIAL_MDW_TIMESTAMP_CONF(port, size)	.timestamp_size = size, .timestamp_storage = port##_timestamp_storage,
+#	else
+#		define SERIAL_MDW_TIMESTAMP_STORAGE(port, size)
+#		define SERIAL_MDW_TIMESTAMP_CONF(port, size)
+#	endif
+#	define SERIAL_MDW_STORAGE(port, rx, tx, timestamp)														\
+	_Static_assert((((rx) & ((rx) - 1)) | ((tx) & ((tx) - 1)) | ((timestamp) & ((timestamp) - 1))) == 0,	\
+		#port " buffer sizes must be powers of two");													\
+	static uint8_t port##_rx_storage[rx] COMPILER_ALIGNED(SERIAL_DMA_CACHE_LINE_SIZE);					\
+	static uint8_t port##_tx_storage[tx];																\
+	SERIAL_MDW_TIMESTAMP_STORAGE(port, timestamp)
+#	define SERIAL_MDW_CONF(port, rx, tx, timestamp)														\
+	{.rx_size = rx, .tx_size = tx, .rx_storage = port##_rx_storage, .tx_storage = port##_tx_storage,	\
+	SERIAL_MDW_TIMESTAMP_CONF(port, timestamp)},
+
+SERIAL_MDW_CONF_BUFFERS(SERIAL_MDW_STORAGE)
+#else
+#	ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+#		define SERIAL_MDW_CONF(port, rx, tx, timestamp)	{.rx_size = rx, .tx_size = tx, .timestamp_size = timestamp},
+#	else
+#		define SERIAL_MDW_CONF(port, rx, tx, timestamp)	{.rx_size = rx, .tx_size = tx},
+#	endif
+#endif
+
+static const serial_mdw_buffer_conf_t serial_mdw_buffer_conf[NUMBER_OF_UART] = {
+	SERIAL_MDW_CONF_BUFFERS(SERIAL_MDW_CONF)
+};
+
+#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+// Framing used until serial_mdw_set_framing is called
+static const serial_framing_conf_t serial_mdw_default_framing = {
+	.mode = SERIAL_FRAMING_DELIMITER,
+	.delimiter = {SERIAL_MDW_DEFAULT_DELIMITER},
+	.delimiter_length = 1
+};
+// Framing of interfaces receiving by DMA : frame ends with the receiver time-out
+static const serial_framing_conf_t serial_mdw_dma_framing = {
+	.mode = SERIAL_FRAMING_IDLE,
+	.idle_bits = SERIAL_MDW_DMA_RX_TIMEOUT
+};
+#endif
 
 /*
    +========================================+
@@ -87,263 +209,658 @@ serial_mdw_buffer_t serial_mdw_buffer[NUMBER_OF_UART] = {0};
 void handle_uart_interrupt(usart_if UART, UART_pointer_t uart_pointer);
 void handle_usart_interrupt(usart_if UART, UART_pointer_t uart_pointer);
 UART_pointer_t uart_buffer_from_UART(usart_if p_usart);
+static inline uint8_t serial_mdw_handle_is_valid(serial_mdw_handle_t handle);
+void serial_mdw_receive_byte(UART_pointer_t uart_pointer, uint8_t uc_char);
+#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+void serial_mdw_frame_store(UART_pointer_t uart_pointer, uint8_t data);
+void serial_mdw_frame_end(UART_pointer_t uart_pointer);
+#endif
+void serial_mdw_frame_next(UART_pointer_t uart_pointer, serial_mdw_frame_t *frame);
+void serial_mdw_frame_release(UART_pointer_t uart_pointer, uint32_t length);
+void serial_mdw_count_errors(UART_pointer_t uart_pointer, uint32_t ul_status, uint32_t overrun, uint32_t framing, uint32_t parity);
+static inline void serial_mdw_rx_notify(UART_pointer_t uart_pointer);
+static void serial_mdw_ready_update(UART_pointer_t uart_pointer);
+static inline void serial_mdw_rx_received(UART_pointer_t uart_pointer, uint32_t rx_bytes);
+static void serial_mdw_rx_check_timeouts(void);
+static inline void serial_mdw_isr_count(UART_pointer_t uart_pointer, uint32_t rx_bytes, uint32_t tx_bytes);
+void serial_mdw_dma_rx_start(UART_pointer_t uart_pointer, volatile const void *p_rhr);
+uint32_t serial_mdw_dma_rx_sync(UART_pointer_t uart_pointer);
+static void serial_mdw_dma_rx_resync(UART_pointer_t uart_pointer);
+void serial_mdw_dma_rx_refresh(UART_pointer_t uart_pointer);
+void serial_mdw_dma_tx_init(UART_pointer_t uart_pointer, volatile void *p_thr);
+void serial_mdw_dma_tx_kick(UART_pointer_t uart_pointer);
+void serial_mdw_dma_tx_complete(UART_pointer_t uart_pointer);
 	
 /*
    +========================================+
 				Functions definition						
    +========================================+
 */
-void serial_mdw_init_interface(usart_if p_usart, const usart_serial_options_t *opt, UART_timestamp_t activate_timestamp)
+status_code_t serial_mdw_init_interface(usart_if p_usart, const usart_serial_options_t *opt, UART_timestamp_t activate_timestamp, UART_dma_t dma_mode, serial_mdw_handle_t *p_handle)
 {
 	sam_uart_opt_t uart_settings;
 	sam_usart_opt_t usart_settings;
 	UART_pointer_t uart_buffer = uart_buffer_from_UART(p_usart);
+	const serial_mdw_buffer_conf_t *conf;
 	
-	// Define properties of interface
-	if(serial_mdw_buffer[uart_buffer].status == NOT_INITIALIZED)
-	{	
-		// Deactivate timestamp by default
-		serial_mdw_buffer[uart_buffer].timestamp_activated =TIMESTAMP_NOT_USED;
-		
-		// Creation of the buffers
-		circ_bbuf_create_buffer(&serial_mdw_buffer[uart_buffer].buffer_rx, SERIAL_MDW_BUFFER_SIZE);
-		circ_bbuf_create_buffer(&serial_mdw_buffer[uart_buffer].buffer_tx, SERIAL_MDW_BUFFER_SIZE);
-		#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
-		serial_mdw_buffer[uart_buffer].timestamp_activated = activate_timestamp;
-		if(activate_timestamp == TIMESTAMP_USED)
+	if(p_handle == NULL)
+	{
+		return ERR_INVALID_ARG;
+	}
+	*p_handle = SERIAL_MDW_HANDLE_INVALID;
+	
+	// Only the UART/USART of the table can be used
+	if(uart_buffer >= NUMBER_OF_UART || opt == NULL)
+	{
+		return ERR_INVALID_ARG;
+	}
+	conf = &serial_mdw_buffer_conf[uart_buffer];
+	
+	// Interface can only be initialized once, handle is given back so that it can be shared
+	if(serial_mdw_buffer[uart_buffer].status == INITIALIZED)
+	{
+		p_handle->p_usart = p_usart;
+		p_handle->slot = uart_buffer;
+		p_handle->type = serial_mdw_port[uart_buffer].type;
+		return ERR_BUSY;
+	}
+	
+	// DMA writes straight into the RX storage : it has to be aligned on cache lines and bytes aren't seen one by one,
+	// timestamped frames can only be closed by the receiver time-out of USARTs
+	if(dma_mode & DMA_RX_USED)
+	{
+		#if defined(SERIAL_MDW_STATIC_BUFFERS)
+		if((activate_timestamp == TIMESTAMP_USED && serial_mdw_port[uart_buffer].type != SERIAL_MDW_USART)
+		|| conf->rx_size < SERIAL_DMA_CACHE_LINE_SIZE)
+		{
+			return ERR_INVALID_ARG;
+		}
+		#else
+		return ERR_UNSUPPORTED_DEV;
+		#endif
+	}
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	// No frame descriptor is reserved for this interface
+	if(activate_timestamp == TIMESTAMP_USED && conf->timestamp_size == 0)
+	{
+		return ERR_INVALID_ARG;
+	}
+	#endif
+	serial_mdw_buffer[uart_buffer].dma_mode = dma_mode;
+	
+	// Deactivate timestamp by default
+	serial_mdw_buffer[uart_buffer].timestamp_activated =TIMESTAMP_NOT_USED;
+	
+	// Creation of the buffers
+	#if defined(SERIAL_MDW_STATIC_BUFFERS)
+	circ_bbuf_init_buffer(&serial_mdw_buffer[uart_buffer].buffer_rx, conf->rx_storage, conf->rx_size);
+	circ_bbuf_init_buffer(&serial_mdw_buffer[uart_buffer].buffer_tx, conf->tx_storage, conf->tx_size);
+	#else
+	if(circ_bbuf_create_buffer(&serial_mdw_buffer[uart_buffer].buffer_rx, conf->rx_size) != CBB_SUCCESS)
+	{
+		serial_mdw_buffer[uart_buffer].status = INIT_ERROR;
+		return ERR_NO_MEMORY;
+	}
+	if(circ_bbuf_create_buffer(&serial_mdw_buffer[uart_buffer].buffer_tx, conf->tx_size) != CBB_SUCCESS)
+	{
+		// Storage already allocated is given back
+		free(serial_mdw_buffer[uart_buffer].buffer_rx.buffer);
+		serial_mdw_buffer[uart_buffer].buffer_rx.buffer = NULL;
+		serial_mdw_buffer[uart_buffer].status = INIT_ERROR;
+		return ERR_NO_MEMORY;
+	}
+	#endif
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	serial_mdw_buffer[uart_buffer].timestamp_activated = activate_timestamp;
+	if(activate_timestamp == TIMESTAMP_USED)
+	{
+		// Frames are kept in the RX buffer, described by the frame queue
+		#if defined(SERIAL_MDW_STATIC_BUFFERS)
+		fq_init_queue(&serial_mdw_buffer[uart_buffer].frames, &serial_mdw_buffer[uart_buffer].buffer_rx,
+					  conf->timestamp_storage, conf->timestamp_size, uart_buffer);
+		#else
+		if(fq_create_queue(&serial_mdw_buffer[uart_buffer].frames, &serial_mdw_buffer[uart_buffer].buffer_rx,
+						   conf->timestamp_size, uart_buffer) != FQ_SUCCESS)
 		{
-			tstp_create_buffer(&serial_mdw_buffer[uart_buffer].timestamp_buff, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE);
-			serial_mdw_buffer[uart_buffer].length_data = 0;
+			free(serial_mdw_buffer[uart_buffer].buffer_rx.buffer);
+			serial_mdw_buffer[uart_buffer].buffer_rx.buffer = NULL;
+			free(serial_mdw_buffer[uart_buffer].buffer_tx.buffer);
+			serial_mdw_buffer[uart_buffer].buffer_tx.buffer = NULL;
+			serial_mdw_buffer[uart_buffer].status = INIT_ERROR;
+			return ERR_NO_MEMORY;
 		}
 		#endif
+		serial_framing_init(&serial_mdw_buffer[uart_buffer].framing,
+							(dma_mode & DMA_RX_USED) ? &serial_mdw_dma_framing : &serial_mdw_default_framing);
+	}
+	#endif
+	
+	// Enable peripheral clock
+	pmc_enable_periph_clk(serial_mdw_port[uart_buffer].id);
+	
+	// Configure UART/USART
+	if(serial_mdw_port[uart_buffer].type == SERIAL_MDW_UART){
 		
-		// Enable peripheral clock
-		pmc_enable_periph_clk(serial_mdw_uart_id_irq[uart_buffer].id);
+		uart_settings.ul_mck = sysclk_get_peripheral_hz();
+		uart_settings.ul_baudrate = opt->baudrate;
+		uart_settings.ul_mode = opt->paritytype;
 		
-		// Configure UART/USART
-		if(UART0 == (Uart*)p_usart || UART1 == (Uart*)p_usart || UART2 == (Uart*)p_usart || UART3 == (Uart*)p_usart || UART4 == (Uart*)p_usart ){
-			
-			uart_settings.ul_mck = sysclk_get_peripheral_hz();
-			uart_settings.ul_baudrate = opt->baudrate;
-			uart_settings.ul_mode = opt->paritytype;
-			
-			uart_init((Uart*)p_usart, &uart_settings);
-			uart_enable_interrupt((Uart*)p_usart, UART_IER_RXRDY);
+		uart_init((Uart*)p_usart, &uart_settings);
+		if(dma_mode & DMA_RX_USED)
+		{
+			serial_mdw_dma_rx_start(uart_buffer, &((Uart*)p_usart)->UART_RHR);
+			uart_enable_interrupt((Uart*)p_usart, SERIAL_MDW_UART_ERRORS);
+		}else
+		{
+			uart_enable_interrupt((Uart*)p_usart, UART_IER_RXRDY | SERIAL_MDW_UART_ERRORS);
 		}
-		else if(USART0 == (Usart*)p_usart || USART1 == (Usart*)p_usart || USART2 == (Usart*)p_usart ){
-			
-			usart_settings.baudrate = opt->baudrate;
-			usart_settings.char_length = opt->charlength;
-			usart_settings.parity_type = opt->paritytype;
-			usart_settings.stop_bits= opt->stopbits;
-			usart_settings.channel_mode= US_MR_CHMODE_NORMAL;
-			
-			usart_init_rs232((Usart*)p_usart, &usart_settings, sysclk_get_peripheral_hz());
-			usart_enable_rx((Usart*)p_usart);
-			usart_enable_interrupt((Usart*)p_usart, US_IER_RXRDY);
+		if(dma_mode & DMA_TX_USED)
+		{
+			serial_mdw_dma_tx_init(uart_buffer, &((Uart*)p_usart)->UART_THR);
+			uart_enable_tx((Uart*)p_usart);
 		}
+	}
+	else{
 		
-		// Enable NVIC interrupts
-		#if !defined(TEST)
-		NVIC_ClearPendingIRQ(serial_mdw_uart_id_irq[uart_buffer].irq);
-		NVIC_EnableIRQ(serial_mdw_uart_id_irq[uart_buffer].irq);
-		#endif
-		// Initialization completed
-		serial_mdw_buffer[uart_buffer].status = INITIALIZED;
+		usart_settings.baudrate = opt->baudrate;
+		usart_settings.char_length = opt->charlength;
+		usart_settings.parity_type = opt->paritytype;
+		usart_settings.stop_bits= opt->stopbits;
+		usart_settings.channel_mode= US_MR_CHMODE_NORMAL;
+		
+		usart_init_rs232((Usart*)p_usart, &usart_settings, sysclk_get_peripheral_hz());
+		usart_enable_rx((Usart*)p_usart);
+		if(dma_mode & DMA_RX_USED)
+		{
+			serial_mdw_dma_rx_start(uart_buffer, &((Usart*)p_usart)->US_RHR);
+			// Receiver time-out publishes the last bytes of a frame once the line is idle
+			usart_set_rx_timeout((Usart*)p_usart, SERIAL_MDW_DMA_RX_TIMEOUT);
+			usart_start_rx_timeout((Usart*)p_usart);
+			usart_enable_interrupt((Usart*)p_usart, US_IER_TIMEOUT | SERIAL_MDW_USART_ERRORS);
+		}else
+		{
+			usart_enable_interrupt((Usart*)p_usart, US_IER_RXRDY | SERIAL_MDW_USART_ERRORS);
+		}
+		if(dma_mode & DMA_TX_USED)
+		{
+			serial_mdw_dma_tx_init(uart_buffer, &((Usart*)p_usart)->US_THR);
+			usart_enable_tx((Usart*)p_usart);
+		}
 	}
-	else
+	
+	// Enable NVIC interrupts
+	#if !defined(TEST)
+	NVIC_ClearPendingIRQ(serial_mdw_port[uart_buffer].irq);
+	NVIC_EnableIRQ(serial_mdw_port[uart_buffer].irq);
+	#endif
+	// Initialization completed
+	serial_mdw_buffer[uart_buffer].status = INITIALIZED;
+	p_handle->p_usart = p_usart;
+	p_handle->slot = uart_buffer;
+	p_handle->type = serial_mdw_port[uart_buffer].type;
+	
+	return STATUS_OK;
+}
+
+status_code_t serial_mdw_send_byte(serial_mdw_handle_t handle, const uint8_t data)
+{
+	UART_pointer_t uart_buffer = handle.slot;
+	status_code_t status = STATUS_OK;
+	
+	if(!serial_mdw_handle_is_valid(handle))
 	{
-		// TODO : handle error case
+		return ERR_INVALID_ARG;
 	}
-
+	
+	if(circ_bbuf_push(&serial_mdw_buffer[uart_buffer].buffer_tx, data) != CBB_SUCCESS)
+	{
+		status = ERR_NO_MEMORY;
+	}
+	
+	if(serial_mdw_buffer[uart_buffer].dma_mode & DMA_TX_USED){
+		serial_mdw_dma_tx_kick(uart_buffer);
+	}
+	else if(handle.type == SERIAL_MDW_UART){
+		uart_enable_tx((Uart*)handle.p_usart);
+		uart_enable_interrupt((Uart*)handle.p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
+	}
+	else{
+		usart_enable_tx((Usart*)handle.p_usart);
+		usart_enable_interrupt((Usart*)handle.p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
+	}
+	
+	return status;
 }
 
-uint8_t serial_mdw_send_byte(usart_if p_usart, const uint8_t data)
+status_code_t serial_mdw_send_bytes(serial_mdw_handle_t handle, const uint8_t *p_buff, uint32_t ulsize)
 {
-	UART_pointer_t uart_buffer = uart_buffer_from_UART(p_usart);
-		
-	uint8_t status = circ_bbuf_push(&serial_mdw_buffer[uart_buffer].buffer_tx, data);
-		
-	if(UART0 == (Uart*)p_usart || UART1 == (Uart*)p_usart || UART2 == (Uart*)p_usart || UART3 == (Uart*)p_usart || UART4 == (Uart*)p_usart ){
-		uart_enable_tx((Uart*)p_usart);
-		uart_enable_interrupt((Uart*)p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
+	UART_pointer_t uart_buffer = handle.slot;
+	status_code_t status = STATUS_OK;
+	
+	if(!serial_mdw_handle_is_valid(handle))
+	{
+		return ERR_INVALID_ARG;
 	}
-	else if(USART0 == (Usart*)p_usart || USART1 == (Usart*)p_usart || USART2 == (Usart*)p_usart ){
-		usart_enable_tx((Usart*)p_usart);
-		usart_enable_interrupt((Usart*)p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
+	
+	if(circ_bbuf_push_bytes(&serial_mdw_buffer[uart_buffer].buffer_tx, p_buff, ulsize) != CBB_SUCCESS)
+	{
+		status = ERR_NO_MEMORY;
+	}
+	
+	if(serial_mdw_buffer[uart_buffer].dma_mode & DMA_TX_USED){
+		serial_mdw_dma_tx_kick(uart_buffer);
+	}
+	else if(handle.type == SERIAL_MDW_UART){
+		uart_enable_tx((Uart*)handle.p_usart);
+		uart_enable_interrupt((Uart*)handle.p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
+	}
+	else{
+		usart_enable_tx((Usart*)handle.p_usart);
+		usart_enable_interrupt((Usart*)handle.p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
 	}
 	
 	return status;
 }
 
-uint8_t serial_mdw_send_bytes(usart_if p_usart, const uint8_t *p_buff, uint32_t ulsize)
+status_code_t serial_mdw_send_buffer(serial_mdw_handle_t handle, const uint8_t *p_buff, uint32_t ulsize, serial_mdw_tx_callback_t callback, void *context)
 {
-		
-	UART_pointer_t uart_buffer = uart_buffer_from_UART(p_usart);
+	UART_pointer_t uart_buffer = handle.slot;
+	serial_mdw_buffer_t *port;
+	irqflags_t flags;
 	
-	uint8_t status = circ_bbuf_push_bytes(&serial_mdw_buffer[uart_buffer].buffer_tx, p_buff, ulsize);
-
-	if(UART0 == (Uart*)p_usart || UART1 == (Uart*)p_usart || UART2 == (Uart*)p_usart || UART3 == (Uart*)p_usart || UART4 == (Uart*)p_usart ){
-		uart_enable_tx((Uart*)p_usart);
-		uart_enable_interrupt((Uart*)p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
+	if(!serial_mdw_handle_is_valid(handle))
+	{
+		return ERR_INVALID_ARG;
+	}
+	port = &serial_mdw_buffer[uart_buffer];
+	if(!(port->dma_mode & DMA_TX_USED))
+	{
+		return ERR_UNSUPPORTED_DEV;
 	}
-	else if(USART0 == (Usart*)p_usart || USART1 == (Usart*)p_usart || USART2 == (Usart*)p_usart ){
-		usart_enable_tx((Usart*)p_usart);
-		usart_enable_interrupt((Usart*)p_usart, UART_IER_TXRDY | UART_IER_TXEMPTY);
+	if(p_buff == NULL || ulsize == 0 || ulsize > SERIAL_DMA_MAX_BLOCK_SIZE)
+	{
+		return ERR_INVALID_ARG;
+	}
+	// Channel is claimed with the interrupts masked : a sender preempting this one (log sink...) finds it busy
+	flags = SERIAL_MDW_LOCK();
+	if(port->dma_tx_state != DMA_TX_IDLE)
+	{
+		SERIAL_MDW_UNLOCK(flags);
+		return ERR_BUSY;
 	}
+	port->dma_tx_state = DMA_TX_BUFFER;
+	port->dma_tx_callback = callback;
+	port->dma_tx_context = context;
+	port->dma_tx_length = ulsize;
+	SERIAL_MDW_UNLOCK(flags);
+	serial_dma_tx_start(XDMAC, SERIAL_MDW_DMA_TX_CHANNEL(uart_buffer), serial_mdw_port[uart_buffer].dma_tx_id, port->dma_thr, p_buff, ulsize);
 	
-	return status;
+	return STATUS_OK;
 }
 
-uint8_t serial_mdw_available(void)
+uint32_t serial_mdw_available(void)
 {
-	uint8_t available_in_buffer = 0;
-	for(uint8_t i = 0; i < NUMBER_OF_UART; i++)
+	uint32_t polled = serial_mdw_dma_rx_polled;
+	
+	serial_mdw_rx_check_timeouts();
+	// USARTs publish the bytes written by their DMA from the receiver time-out interrupt, UARTs have to be asked
+	while(polled != 0)
 	{
-		if (serial_mdw_buffer[i].timestamp_activated == TIMESTAMP_USED
-		&& tstp_buf_is_empty(&serial_mdw_buffer[i].timestamp_buff) == false)
-		{
-			available_in_buffer |= 1 << i;
-		}
-		if (serial_mdw_buffer[i].timestamp_activated == TIMESTAMP_NOT_USED
-		&& circ_bbuf_is_empty(&serial_mdw_buffer[i].buffer_rx) == false )
+		serial_mdw_dma_rx_refresh(__builtin_ctz(polled));
+		polled &= polled - 1;
+	}
+	
+	return __atomic_load_n(&serial_mdw_ready, __ATOMIC_ACQUIRE);
+}
+
+uint8_t serial_mdw_next_ready(serial_mdw_handle_t *p_handle)
+{
+	uint32_t ready = serial_mdw_available();
+	uint32_t after_last;
+	uint8_t slot;
+	
+	if(ready == 0) return false;
+	
+	// Interfaces after the last one given come first, so that a busy interface doesn't hide the others
+	after_last = ready & ~((2UL << serial_mdw_ready_last) - 1);
+	slot = (uint8_t)__builtin_ctz((after_last != 0) ? after_last : ready);
+	serial_mdw_ready_last = slot;
+	
+	p_handle->p_usart = serial_mdw_port[slot].p_usart;
+	p_handle->slot = slot;
+	p_handle->type = serial_mdw_port[slot].type;
+	
+	return true;
+}
+
+status_code_t serial_mdw_set_rx_callback(serial_mdw_handle_t handle, serial_mdw_rx_callback_t callback, void *context)
+{
+	if(!serial_mdw_handle_is_valid(handle)) return ERR_INVALID_ARG;
+	
+	// Interrupt of the interface mustn't see a callback with the context of another one
+	#if !defined(TEST)
+	NVIC_DisableIRQ(serial_mdw_port[handle.slot].irq);
+	#endif
+	serial_mdw_buffer[handle.slot].rx_callback = callback;
+	serial_mdw_buffer[handle.slot].rx_context = context;
+	#if !defined(TEST)
+	NVIC_EnableIRQ(serial_mdw_port[handle.slot].irq);
+	#endif
+	
+	return STATUS_OK;
+}
+
+status_code_t serial_mdw_set_rx_watermark(serial_mdw_handle_t handle, uint32_t bytes, uint32_t timeout_ms)
+{
+	serial_mdw_buffer_t *port;
+	
+	if(!serial_mdw_handle_is_valid(handle)) return ERR_INVALID_ARG;
+	
+	port = &serial_mdw_buffer[handle.slot];
+	if(bytes > port->buffer_rx.capacity || timeout_ms > SERIAL_MDW_RX_TIMEOUT_MAX_MS) return ERR_INVALID_ARG;
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	if(port->timestamp_activated == TIMESTAMP_USED) return ERR_UNSUPPORTED_DEV;
+	#endif
+	
+	// Time-out alone waits for a full buffer
+	if(bytes == 0 && timeout_ms != 0) bytes = port->buffer_rx.capacity;
+	
+	#if !defined(TEST)
+	NVIC_DisableIRQ(serial_mdw_port[handle.slot].irq);
+	#endif
+	port->rx_watermark = bytes;
+	port->rx_timeout_us = timeout_ms * 1000;
+	// Data already received is counted from now
+	port->rx_since_us = (uint32_t)timebase_monotonic_us();
+	serial_mdw_ready_update(handle.slot);
+	#if !defined(TEST)
+	NVIC_EnableIRQ(serial_mdw_port[handle.slot].irq);
+	#endif
+	
+	return STATUS_OK;
+}
+
+uint32_t serial_mdw_take_rx_events(void)
+{
+	return __atomic_exchange_n(&serial_mdw_rx_events, 0, __ATOMIC_ACQUIRE);
+}
+
+uint32_t serial_mdw_wait_rx_events(void)
+{
+	uint32_t events = serial_mdw_take_rx_events();
+	
+	#if !defined(TEST)
+	// Interrupts are masked between the check and WFI : an event raised in between still wakes the core up,
+	// its handler runs once they are unmasked. pmc_sleep unmasks them before WFI, such an event would wait for the next interrupt.
+	while(events == 0)
+	{
+		// Core is woken up at least every millisecond by the SysTick
+		serial_mdw_rx_check_timeouts();
+		cpu_irq_disable();
+		if(serial_mdw_rx_events == 0)
 		{
-			available_in_buffer |= 1 << i;
+			SCB->SCR &= (uint32_t)~SCB_SCR_SLEEPDEEP_Msk;
+			__DSB();
+			__WFI();
 		}
+		cpu_irq_enable();
+		events = serial_mdw_take_rx_events();
 	}
+	#endif
 	
-	return available_in_buffer;
+	return events;
 }
 
-uint32_t serial_mdw_available_bytes(usart_if p_usart)
+uint32_t serial_mdw_available_bytes(serial_mdw_handle_t handle)
 {
-	uint8_t uart_buffer = uart_buffer_from_UART(p_usart);
+	UART_pointer_t uart_buffer = handle.slot;
+	
+	if(!serial_mdw_handle_is_valid(handle)) return 0;
+	
+	serial_mdw_dma_rx_refresh(uart_buffer);
 	return circ_bbuf_available_bytes_to_read(&serial_mdw_buffer[uart_buffer].buffer_rx);
 }
 
-uint8_t serial_mdw_read_byte(usart_if p_usart, uint8_t *data)
+uint8_t serial_mdw_read_byte(serial_mdw_handle_t handle, uint8_t *data)
 {
-	uint8_t uart_buffer = uart_buffer_from_UART(p_usart);
+	UART_pointer_t uart_buffer = handle.slot;
 	uint8_t success = false;
-	if (serial_mdw_buffer[uart_buffer].timestamp_activated == TIMESTAMP_NOT_USED)
+	if (serial_mdw_handle_is_valid(handle) && serial_mdw_buffer[uart_buffer].timestamp_activated == TIMESTAMP_NOT_USED)
 	{
+		serial_mdw_dma_rx_refresh(uart_buffer);
 		circ_bbuf_pop(&serial_mdw_buffer[uart_buffer].buffer_rx, data);
+		serial_mdw_ready_update(uart_buffer);
 		success = true;
 	}
 	return success;
 }
 
-uint8_t serial_mdw_read_bytes(usart_if p_usart, uint8_t *p_buff, uint32_t ulsize)
+uint8_t serial_mdw_read_bytes(serial_mdw_handle_t handle, uint8_t *p_buff, uint32_t ulsize)
 {
-	uint8_t uart_buffer = uart_buffer_from_UART(p_usart);
+	UART_pointer_t uart_buffer = handle.slot;
 	uint8_t success = false;
-	if (serial_mdw_buffer[uart_buffer].timestamp_activated == TIMESTAMP_NOT_USED)
+	if (serial_mdw_handle_is_valid(handle) && serial_mdw_buffer[uart_buffer].timestamp_activated == TIMESTAMP_NOT_USED)
 	{
+		serial_mdw_dma_rx_refresh(uart_buffer);
 		circ_bbuf_pop_bytes(&serial_mdw_buffer[uart_buffer].buffer_rx, ulsize, p_buff);
+		serial_mdw_ready_update(uart_buffer);
 		success = true;
 	}
 	return success;
 }
 
+status_code_t serial_mdw_get_stats(serial_mdw_handle_t handle, serial_mdw_stats_t *stats)
+{
+	if(!serial_mdw_handle_is_valid(handle))
+	{
+		return ERR_INVALID_ARG;
+	}
+	
+	// Counters are written by the interrupts only, each one is read atomically but the copy isn't a snapshot
+	*stats = serial_mdw_buffer[handle.slot].stats;
+	
+	return STATUS_OK;
+}
+
+#if defined(SERIAL_MDW_ISR_COUNTERS)
+status_code_t serial_mdw_get_isr_counters(serial_mdw_handle_t handle, serial_mdw_isr_counters_t *counters)
+{
+	if(!serial_mdw_handle_is_valid(handle))
+	{
+		return ERR_INVALID_ARG;
+	}
+	
+	// 32 bits counters are written by the interrupt only, each one is read atomically
+	*counters = serial_mdw_buffer[handle.slot].isr_counters;
+	
+	return STATUS_OK;
+}
+#endif
+
 #if defined(SERIAL_MDW_TIMESTAMP_ACTIVATED)
-uint32_t serial_mdw_timestamp_available(usart_if p_usart)
+uint32_t serial_mdw_timestamp_available(serial_mdw_handle_t handle)
 {
-	UART_pointer_t uart_buffer = uart_buffer_from_UART(p_usart);
+	UART_pointer_t uart_buffer = handle.slot;
 	uint32_t number_of_bytes = 0;
 	
+	if(!serial_mdw_handle_is_valid(handle)) return 0;
+	
 	if (serial_mdw_buffer[uart_buffer].timestamp_activated == TIMESTAMP_USED)
 	{
-		number_of_bytes = tstp_available_to_read(&serial_mdw_buffer[uart_buffer].timestamp_buff);
+		serial_mdw_dma_rx_resync(uart_buffer);
+		number_of_bytes = fq_available_frames(&serial_mdw_buffer[uart_buffer].frames);
 	}else
 	{
+		serial_mdw_dma_rx_refresh(uart_buffer);
 		number_of_bytes = circ_bbuf_available_bytes_to_read(&serial_mdw_buffer[uart_buffer].buffer_rx);
 	}
 	
 	return number_of_bytes;
 }
-uint8_t serial_mdw_timestamp_read(usart_if p_usart, serial_mdw_data_timestamp_t *data_timestamp)
+
+status_code_t serial_mdw_set_framing(serial_mdw_handle_t handle, const serial_framing_conf_t *conf)
 {
-	UART_pointer_t uart_buffer = uart_buffer_from_UART(p_usart);
-	uint8_t result_read = 0;
+	serial_mdw_buffer_t *port;
+	serial_framing_mode_t previous_mode;
+	status_code_t status;
 	
-	if (serial_mdw_buffer[uart_buffer].timestamp_activated == TIMESTAMP_USED)
+	if(!serial_mdw_handle_is_valid(handle) || conf == NULL)
 	{
-		timestamp_t timestamp;
+		return ERR_INVALID_ARG;
+	}
+	port = &serial_mdw_buffer[handle.slot];
+	// Frames are recorded into the frame queue, idle line is detected by the receiver time-out of USARTs
+	// and bytes received by DMA can only be framed by the idle line
+	if(port->timestamp_activated != TIMESTAMP_USED
+	|| (conf->mode == SERIAL_FRAMING_IDLE && handle.type != SERIAL_MDW_USART)
+	|| (conf->mode != SERIAL_FRAMING_IDLE && (port->dma_mode & DMA_RX_USED)))
+	{
+		return ERR_UNSUPPORTED_DEV;
+	}
+	
+	// Engine is changed while the interrupt of the interface is masked, frame in progress is kept
+	#if !defined(TEST)
+	NVIC_DisableIRQ(serial_mdw_port[handle.slot].irq);
+	#endif
+	previous_mode = port->framing.conf.mode;
+	status = serial_framing_init(&port->framing, conf);
+	if(status == STATUS_OK && conf->mode == SERIAL_FRAMING_IDLE)
+	{
+		usart_set_rx_timeout((Usart*)handle.p_usart, conf->idle_bits);
+		usart_start_rx_timeout((Usart*)handle.p_usart);
+		usart_enable_interrupt((Usart*)handle.p_usart, US_IER_TIMEOUT);
+	}
+	else if(status == STATUS_OK && previous_mode == SERIAL_FRAMING_IDLE)
+	{
+		usart_disable_interrupt((Usart*)handle.p_usart, US_IDR_TIMEOUT);
+	}
+	#if !defined(TEST)
+	NVIC_EnableIRQ(serial_mdw_port[handle.slot].irq);
+	#endif
+	
+	return status;
+}
+#endif
 
-		result_read = tstp_buf_pop(&serial_mdw_buffer[uart_buffer].timestamp_buff, &timestamp);
-		data_timestamp->timestamp = timestamp.timestamp;
-		data_timestamp->length = timestamp.length;
-		
-		if(result_read == TB_SUCCESS)
+status_code_t serial_mdw_frame_read(serial_mdw_handle_t handle, uint8_t *p_buff, uint32_t capacity, uint32_t *p_length, uint64_t *p_timestamp)
+{
+	UART_pointer_t uart_buffer = handle.slot;
+	serial_mdw_frame_t frame = {.length = {0, 0}, .timestamp = 0};
+	uint32_t length;
+	
+	*p_length = 0;
+	if(!serial_mdw_handle_is_valid(handle))
+	{
+		return ERR_INVALID_ARG;
+	}
+	
+	serial_mdw_frame_next(uart_buffer, &frame);
+	length = frame.length[0] + frame.length[1];
+	if(length > capacity)
+	{
+		#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+		// A timestamped frame is never split : caller can retry with a bigger buffer
+		if(serial_mdw_buffer[uart_buffer].timestamp_activated == TIMESTAMP_USED)
 		{
-			uint8_t *data = (uint8_t *)malloc(sizeof(uint8_t) * timestamp.length);
-			result_read = circ_bbuf_pop_bytes(&serial_mdw_buffer[uart_buffer].buffer_rx, timestamp.length, data);
-			data_timestamp->data = data;
+			*p_length = length;
+			return ERR_NO_MEMORY;
 		}
-	}else
+		#endif
+		length = capacity;
+		if(frame.length[0] > length) frame.length[0] = length;
+		frame.length[1] = length - frame.length[0];
+	}
+	
+	if(frame.length[0] != 0) memcpy(p_buff, frame.data[0], frame.length[0]);
+	if(frame.length[1] != 0) memcpy(p_buff + frame.length[0], frame.data[1], frame.length[1]);
+	serial_mdw_frame_release(uart_buffer, length);
+	
+	*p_length = length;
+	if(p_timestamp != NULL)
 	{
-		uint8_t *data = (uint8_t *)malloc(sizeof(uint8_t)); // TODO : handle the free() of data, only one byte retrieved
-		result_read = circ_bbuf_pop(&serial_mdw_buffer[uart_buffer].buffer_rx, data);
-		data_timestamp->timestamp = 0;
-		data_timestamp->length = 1;
-		data_timestamp->data = data;
+		*p_timestamp = frame.timestamp;
 	}
+	return STATUS_OK;
+}
 
-	return result_read;
+status_code_t serial_mdw_frame_peek(serial_mdw_handle_t handle, serial_mdw_frame_t *frame)
+{
+	frame->data[0] = NULL;
+	frame->data[1] = NULL;
+	frame->length[0] = 0;
+	frame->length[1] = 0;
+	frame->timestamp = 0;
+	frame->errors = 0;
+	if(!serial_mdw_handle_is_valid(handle))
+	{
+		return ERR_INVALID_ARG;
+	}
+	
+	serial_mdw_frame_next(handle.slot, frame);
+	
+	return STATUS_OK;
 }
 
-#endif
+status_code_t serial_mdw_frame_commit(serial_mdw_handle_t handle, const serial_mdw_frame_t *frame)
+{
+	uint32_t length = frame->length[0] + frame->length[1];
+	
+	if(!serial_mdw_handle_is_valid(handle))
+	{
+		return ERR_INVALID_ARG;
+	}
+	
+	serial_mdw_frame_release(handle.slot, length);
+	
+	return STATUS_OK;
+}
 	
 void handle_uart_interrupt(usart_if UART, UART_pointer_t uart_pointer)
 {
 	uint8_t uc_char;
 	uint32_t ul_status;
+	uint32_t rx_bytes = 0;
+	uint32_t tx_bytes = 0;
 
 	// Read UART status.
 	ul_status = uart_get_status((Uart*)UART);
+	
+	// Reception errors are counted then cleared
+	if(ul_status & SERIAL_MDW_UART_ERRORS) {
+		serial_mdw_count_errors(uart_pointer, ul_status, UART_SR_OVRE, UART_SR_FRAME, UART_SR_PARE);
+		uart_reset_status((Uart*)UART);
+	}
 		
-	// Transmit interrupt
-	if(ul_status & (UART_IER_TXRDY | UART_IER_TXEMPTY)) {
+	// Transmit interrupt, transmission by DMA is handled by XDMAC_Handler
+	if(!(serial_mdw_buffer[uart_pointer].dma_mode & DMA_TX_USED) && (ul_status & (UART_IER_TXRDY | UART_IER_TXEMPTY))) {
 		if (!circ_bbuf_is_empty(&serial_mdw_buffer[uart_pointer].buffer_tx)) {
-			circ_bbuf_pop(&serial_mdw_buffer[uart_pointer].buffer_tx, &uc_char);
-			uart_write((Uart*)UART, uc_char);
+			// Holding register is refilled as long as it is ready
+			do {
+				circ_bbuf_pop(&serial_mdw_buffer[uart_pointer].buffer_tx, &uc_char);
+				uart_write((Uart*)UART, uc_char);
+				tx_bytes++;
+			} while((uart_get_status((Uart*)UART) & UART_SR_TXRDY) && !circ_bbuf_is_empty(&serial_mdw_buffer[uart_pointer].buffer_tx));
 			}else{
 			// Nothing more to transmit for now, deactivating interrupt
 			uart_disable_interrupt((Uart*)UART, (UART_IER_TXRDY | UART_IER_TXEMPTY));
 			uart_disable_tx((Uart*)UART);
 		}
 	}
-	// Receive interrupt
-	if (ul_status & UART_SR_RXRDY ) {
-		uart_read((Uart*)UART, &uc_char);
-
-		if(!circ_bbuf_push(&serial_mdw_buffer[uart_pointer].buffer_rx, uc_char) && serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
-		{
-			// Check if timestamp has to be acquired
-			#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
-			serial_mdw_buffer[uart_pointer].length_data += 1;
-
-			if (serial_mdw_buffer[uart_pointer].timestamp == 0)
-			{
-				serial_mdw_buffer[uart_pointer].timestamp = unix_timestamp_ms;
-			}
-			// If character matches, then next character has to be timestamp and can be saved into timestamp buffer
-			if(uc_char == char_to_compare_for_timestamp)
-			{
-				timestamp_t timestamp;
-				// put info into struct
-				timestamp.position = serial_mdw_buffer[uart_pointer].buffer_rx.head;
-				timestamp.timestamp = serial_mdw_buffer[uart_pointer].timestamp;
-				timestamp.length = serial_mdw_buffer[uart_pointer].length_data;
-				// push struct into buffer
-				tstp_buf_push(&serial_mdw_buffer[uart_pointer].timestamp_buff, &timestamp);
-				// reset
-				serial_mdw_buffer[uart_pointer].timestamp = 0;
-				serial_mdw_buffer[uart_pointer].length_data = 0;
-			}
-			#endif
-		}
+	// Bytes received by DMA
+	if(serial_mdw_buffer[uart_pointer].dma_mode & DMA_RX_USED) {
+		rx_bytes = serial_mdw_dma_rx_sync(uart_pointer);
+	}
+	// Receive interrupt : every byte already received is read in this entry
+	else if (ul_status & UART_SR_RXRDY ) {
+		do {
+			uart_read((Uart*)UART, &uc_char);
+			serial_mdw_receive_byte(uart_pointer, uc_char);
+			rx_bytes++;
+		} while(uart_get_status((Uart*)UART) & UART_SR_RXRDY);
 	}
+	
+	serial_mdw_rx_received(uart_pointer, rx_bytes);
+	serial_mdw_isr_count(uart_pointer, rx_bytes, tx_bytes);
 }
 
 void handle_usart_interrupt(usart_if USART, UART_pointer_t uart_pointer)
@@ -351,52 +868,347 @@ void handle_usart_interrupt(usart_if USART, UART_pointer_t uart_pointer)
 	uint32_t uc_char;
 	uint32_t ul_status;
 	uint8_t temp_char;
+	uint32_t rx_bytes = 0;
+	uint32_t tx_bytes = 0;
 
 	// Read UART status.
 	ul_status = usart_get_status((Usart*)USART);
 	
-	// Transmit interrupt
-	if(ul_status & (US_CSR_TXRDY | US_CSR_TXEMPTY)) {
+	// Reception errors are counted then cleared
+	if(ul_status & SERIAL_MDW_USART_ERRORS) {
+		serial_mdw_count_errors(uart_pointer, ul_status, US_CSR_OVRE, US_CSR_FRAME, US_CSR_PARE);
+		usart_reset_status((Usart*)USART);
+	}
+	
+	// Transmit interrupt, transmission by DMA is handled by XDMAC_Handler
+	if(!(serial_mdw_buffer[uart_pointer].dma_mode & DMA_TX_USED) && (ul_status & (US_CSR_TXRDY | US_CSR_TXEMPTY))) {
 		if (!circ_bbuf_is_empty(&serial_mdw_buffer[uart_pointer].buffer_tx)) {
-			circ_bbuf_pop(&serial_mdw_buffer[uart_pointer].buffer_tx, &temp_char);
-			uc_char = (uint32_t)temp_char;
-			usart_write((Usart*)USART, uc_char);
+			// Holding register is refilled as long as it is ready
+			do {
+				circ_bbuf_pop(&serial_mdw_buffer[uart_pointer].buffer_tx, &temp_char);
+				uc_char = (uint32_t)temp_char;
+				usart_write((Usart*)USART, uc_char);
+				tx_bytes++;
+			} while((usart_get_status((Usart*)USART) & US_CSR_TXRDY) && !circ_bbuf_is_empty(&serial_mdw_buffer[uart_pointer].buffer_tx));
 			}else{
 			// Nothing more to transmit for now, deactivating interrupt
 			usart_disable_interrupt((Usart*)USART, (US_IER_TXRDY | US_IER_TXEMPTY)); 
 			usart_disable_tx((Usart*)USART);
 		}
 	}
-	// Receive interrupt
-	if (ul_status & US_CSR_RXRDY ) {
-		if(circ_bbuf_is_empty(&serial_mdw_buffer[uart_pointer].buffer_rx)){
+	// Bytes received by DMA
+	if(serial_mdw_buffer[uart_pointer].dma_mode & DMA_RX_USED) {
+		rx_bytes = serial_mdw_dma_rx_sync(uart_pointer);
+	}
+	// Receive interrupt : every byte already received is read in this entry
+	else if (ul_status & US_CSR_RXRDY ) {
+		do {
 			usart_read((Usart*)USART, &uc_char);
-			circ_bbuf_push(&serial_mdw_buffer[uart_pointer].buffer_rx, uc_char);
-			// Check if timestamp has to be acquired
-			#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
-			serial_mdw_buffer[uart_pointer].length_data += 1;
-
-			if (serial_mdw_buffer[uart_pointer].timestamp == 0)
-			{
-				serial_mdw_buffer[uart_pointer].timestamp = unix_timestamp_ms;
-			}
-			// If character matches, then next character has to be timestamp and can be saved into timestamp buffer
-			if(uc_char == char_to_compare_for_timestamp)
-			{
-				timestamp_t timestamp;
-				// put info into struct
-				timestamp.position = serial_mdw_buffer[uart_pointer].buffer_rx.head;
-				timestamp.timestamp = serial_mdw_buffer[uart_pointer].timestamp;
-				timestamp.length = serial_mdw_buffer[uart_pointer].length_data;
-				// push struct into buffer
-				tstp_buf_push(&serial_mdw_buffer[uart_pointer].timestamp_buff, &timestamp);
-				// reset
-				serial_mdw_buffer[uart_pointer].timestamp = 0;
-				serial_mdw_buffer[uart_pointer].length_data = 0;
-			}
+			serial_mdw_receive_byte(uart_pointer, (uint8_t)uc_char);
+			rx_bytes++;
+		} while(usart_get_status((Usart*)USART) & US_CSR_RXRDY);
+	}
+	// Line is idle : time-out is started again on the next received character
+	if(ul_status & US_CSR_TIMEOUT) {
+		usart_start_rx_timeout((Usart*)USART);
+		#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+		if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED
+		&& serial_mdw_buffer[uart_pointer].framing.conf.mode == SERIAL_FRAMING_IDLE) {
+			serial_mdw_frame_end(uart_pointer);
+		}
+		#endif
+	}
+	
+	serial_mdw_rx_received(uart_pointer, rx_bytes);
+	serial_mdw_isr_count(uart_pointer, rx_bytes, tx_bytes);
+}
+
+// Frame is left untouched when nothing has been received
+void serial_mdw_frame_next(UART_pointer_t uart_pointer, serial_mdw_frame_t *frame)
+{
+	circ_bbuf_t *buffer_rx = &serial_mdw_buffer[uart_pointer].buffer_rx;
+	uint8_t *data[2];
+	uint32_t length;
+	
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+	{
+		frame_desc_t desc;
+		
+		serial_mdw_dma_rx_resync(uart_pointer);
+		if(fq_peek(&serial_mdw_buffer[uart_pointer].frames, &desc) != FQ_SUCCESS) return;
+		
+		fq_frame_data(&serial_mdw_buffer[uart_pointer].frames, &desc, data, frame->length);
+		frame->data[0] = data[0];
+		frame->data[1] = data[1];
+		frame->timestamp = desc.timestamp;
+		frame->errors = desc.errors;
+		return;
+	}
+	#endif
+	
+	// Without timestamp, every byte received makes the frame, going on at the start of the storage when it wraps around
+	serial_mdw_dma_rx_refresh(uart_pointer);
+	length = circ_bbuf_available_bytes_to_read(buffer_rx);
+	if(length == 0) return;
+	
+	frame->length[0] = circ_bbuf_peek_contiguous(buffer_rx, &data[0]);
+	if(frame->length[0] > length) frame->length[0] = length;
+	frame->data[0] = data[0];
+	if(length > frame->length[0])
+	{
+		frame->data[1] = buffer_rx->buffer;
+		frame->length[1] = length - frame->length[0];
+	}
+}
+
+void serial_mdw_frame_release(UART_pointer_t uart_pointer, uint32_t length)
+{
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	// A timestamped frame is released whole with its descriptor
+	if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+	{
+		if(length != 0) fq_release(&serial_mdw_buffer[uart_pointer].frames);
+	}else
+	#endif
+	{
+		circ_bbuf_skip(&serial_mdw_buffer[uart_pointer].buffer_rx, length);
+	}
+	serial_mdw_ready_update(uart_pointer);
+}
+
+// Bit is cleared before checking the buffer : data published by the interrupt in between sets it again
+static void serial_mdw_ready_update(UART_pointer_t uart_pointer)
+{
+	uint8_t empty;
+	
+	__atomic_fetch_and(&serial_mdw_ready, ~(1UL << uart_pointer), __ATOMIC_SEQ_CST);
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+	{
+		empty = (fq_available_frames(&serial_mdw_buffer[uart_pointer].frames) == 0);
+	}else
+	#endif
+	{
+		empty = circ_bbuf_is_empty(&serial_mdw_buffer[uart_pointer].buffer_rx);
+	}
+	if(empty)
+	{
+		__atomic_fetch_and(&serial_mdw_rx_waiting, ~(1UL << uart_pointer), __ATOMIC_RELAXED);
+	}else if(circ_bbuf_available_bytes_to_read(&serial_mdw_buffer[uart_pointer].buffer_rx) >= serial_mdw_buffer[uart_pointer].rx_watermark)
+	{
+		__atomic_fetch_or(&serial_mdw_ready, 1UL << uart_pointer, __ATOMIC_RELAXED);
+	}else
+	{
+		// Below the watermark, the time-out counts from this read
+		serial_mdw_buffer[uart_pointer].rx_since_us = (uint32_t)timebase_monotonic_us();
+		__atomic_fetch_or(&serial_mdw_rx_waiting, 1UL << uart_pointer, __ATOMIC_RELAXED);
+	}
+}
+
+// Interfaces waiting for too long are given to their interrupt, which notifies them
+static void serial_mdw_rx_check_timeouts(void)
+{
+	uint32_t waiting = serial_mdw_rx_waiting;
+	uint32_t now;
+	
+	if(waiting == 0) return;
+	
+	now = (uint32_t)timebase_monotonic_us();
+	while(waiting != 0)
+	{
+		uint8_t slot = (uint8_t)__builtin_ctz(waiting);
+		
+		if(serial_mdw_buffer[slot].rx_timeout_us != 0 && now - serial_mdw_buffer[slot].rx_since_us >= serial_mdw_buffer[slot].rx_timeout_us)
+		{
+			#if defined(TEST)
+			serial_mdw_rx_received(slot, 0);
+			#else
+			NVIC_SetPendingIRQ(serial_mdw_port[slot].irq);
+			__DSB();
+			__ISB();
 			#endif
 		}
+		waiting &= waiting - 1;
+	}
+}
+
+void serial_mdw_receive_byte(UART_pointer_t uart_pointer, uint8_t uc_char)
+{
+	// Frames are detected by the framing engine of the interface when timestamp is used
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+	{
+		uint8_t result = serial_framing_receive(&serial_mdw_buffer[uart_pointer].framing, uc_char, &uc_char);
+		
+		if(result & SERIAL_FRAMING_DATA)
+		{
+			serial_mdw_frame_store(uart_pointer, uc_char);
+		}
+		if(result & SERIAL_FRAMING_END)
+		{
+			serial_mdw_frame_end(uart_pointer);
+		}
+		return;
+	}
+	#endif
+	
+	if(circ_bbuf_push(&serial_mdw_buffer[uart_pointer].buffer_rx, uc_char) != CBB_SUCCESS)
+	{
+		serial_mdw_buffer[uart_pointer].stats.rx_dropped++;
+	}
+}
+
+#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+void serial_mdw_frame_store(UART_pointer_t uart_pointer, uint8_t data)
+{
+	frame_queue_t *frames = &serial_mdw_buffer[uart_pointer].frames;
+	uint8_t result = fq_push(frames, data);
+	
+	// Bytes of a frame which doesn't fit are dropped until its end, the RX buffer has been full before they are forgotten
+	if(result != FQ_SUCCESS)
+	{
+		if(result == FQ_BYTES_FULL)
+		{
+			serial_mdw_buffer[uart_pointer].stats.rx_high_water = serial_mdw_buffer[uart_pointer].buffer_rx.capacity;
+		}
+		serial_mdw_buffer[uart_pointer].stats.rx_dropped++;
+		return;
+	}
+	
+	// Frame is timestamped on its first byte
+	if(fq_pending_length(frames) == 1)
+	{
+		fq_set_timestamp(frames, timebase_unix_us());
+	}
+}
+
+void serial_mdw_frame_end(UART_pointer_t uart_pointer)
+{
+	// Bytes and descriptor are published together, nothing is published for an empty frame (SLIP, idle line...)
+	uint8_t result;
+	
+	// Queue overrun by the DMA waits for the reader : a frame cut by the overrun is dropped, the next one starts after this end
+	if(serial_mdw_buffer[uart_pointer].dma_rx_overrun)
+	{
+		if(serial_mdw_buffer[uart_pointer].dma_rx_overrun == SERIAL_MDW_DMA_RX_OVERRUN)
+		{
+			serial_mdw_buffer[uart_pointer].stats.frames_dropped++;
+		}
+		serial_mdw_buffer[uart_pointer].dma_rx_overrun = SERIAL_MDW_DMA_RX_OVERRUN_IDLE;
+		return;
+	}
+	
+	result = fq_end(&serial_mdw_buffer[uart_pointer].frames);
+	if(result == FQ_SUCCESS)
+	{
+		serial_mdw_buffer[uart_pointer].stats.frames_timestamped++;
+		serial_mdw_rx_notify(uart_pointer);
+	}else if(result != FQ_EMPTY)
+	{
+		serial_mdw_buffer[uart_pointer].stats.frames_dropped++;
+	}
+}
+#endif
+
+void serial_mdw_count_errors(UART_pointer_t uart_pointer, uint32_t ul_status, uint32_t overrun, uint32_t framing, uint32_t parity)
+{
+	serial_mdw_stats_t *stats = &serial_mdw_buffer[uart_pointer].stats;
+	
+	if(ul_status & overrun) stats->overrun_errors++;
+	if(ul_status & framing) stats->framing_errors++;
+	if(ul_status & parity) stats->parity_errors++;
+	
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	// Errors are given with the frame in progress
+	if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+	{
+		fq_add_errors(&serial_mdw_buffer[uart_pointer].frames, ((ul_status & overrun) ? SERIAL_MDW_FRAME_OVERRUN : 0)
+														   | ((ul_status & framing) ? SERIAL_MDW_FRAME_FRAMING : 0)
+														   | ((ul_status & parity) ? SERIAL_MDW_FRAME_PARITY : 0));
+	}
+	#endif
+}
+
+static inline void serial_mdw_rx_notify(UART_pointer_t uart_pointer)
+{
+	serial_mdw_buffer_t *port = &serial_mdw_buffer[uart_pointer];
+	
+	__atomic_fetch_or(&serial_mdw_ready, 1UL << uart_pointer, __ATOMIC_RELEASE);
+	__atomic_fetch_or(&serial_mdw_rx_events, 1UL << uart_pointer, __ATOMIC_RELEASE);
+	if(port->rx_callback != NULL)
+	{
+		port->rx_callback((serial_mdw_handle_t){.p_usart = serial_mdw_port[uart_pointer].p_usart, .slot = uart_pointer,
+												.type = serial_mdw_port[uart_pointer].type}, port->rx_context);
+	}
+}
+
+// Without timestamp, the reader is notified once per interrupt entry, or once when the watermark or its time-out is reached.
+// Timestamped frames are notified when they end
+static inline void serial_mdw_rx_received(UART_pointer_t uart_pointer, uint32_t rx_bytes)
+{
+	serial_mdw_buffer_t *port = &serial_mdw_buffer[uart_pointer];
+	uint32_t bit = 1UL << uart_pointer;
+	uint32_t fill;
+	
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	if(port->timestamp_activated == TIMESTAMP_USED) return;
+	#endif
+	if(port->rx_watermark == 0)
+	{
+		if(rx_bytes != 0) serial_mdw_rx_notify(uart_pointer);
+		return;
+	}
+	
+	// Already notified : nothing more until the reader has read
+	if(serial_mdw_ready & bit) return;
+	fill = circ_bbuf_available_bytes_to_read(&port->buffer_rx);
+	if(fill == 0) return;
+	
+	if(fill >= port->rx_watermark
+	|| ((serial_mdw_rx_waiting & bit) && port->rx_timeout_us != 0 && (uint32_t)timebase_monotonic_us() - port->rx_since_us >= port->rx_timeout_us))
+	{
+		__atomic_fetch_and(&serial_mdw_rx_waiting, ~bit, __ATOMIC_RELAXED);
+		serial_mdw_rx_notify(uart_pointer);
+	}else if(!(serial_mdw_rx_waiting & bit))
+	{
+		port->rx_since_us = (uint32_t)timebase_monotonic_us();
+		__atomic_fetch_or(&serial_mdw_rx_waiting, bit, __ATOMIC_RELAXED);
+	}
+}
+
+static inline void serial_mdw_isr_count(UART_pointer_t uart_pointer, uint32_t rx_bytes, uint32_t tx_bytes)
+{
+	serial_mdw_stats_t *stats = &serial_mdw_buffer[uart_pointer].stats;
+	
+	stats->rx_bytes += rx_bytes;
+	stats->tx_bytes += tx_bytes;
+	// Fill level only grows in the interrupt : peak is checked once per entry
+	if(rx_bytes != 0)
+	{
+		uint32_t fill = circ_bbuf_available_bytes_to_read(&serial_mdw_buffer[uart_pointer].buffer_rx);
+		#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+		// Frame in progress isn't published yet
+		if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+		{
+			fill = serial_mdw_buffer[uart_pointer].frames.write - serial_mdw_buffer[uart_pointer].buffer_rx.tail;
+		}
+		#endif
+		if(fill > stats->rx_high_water)
+		{
+			stats->rx_high_water = fill;
+		}
 	}
+	
+	#if defined(SERIAL_MDW_ISR_COUNTERS)
+	serial_mdw_isr_counters_t *counters = &serial_mdw_buffer[uart_pointer].isr_counters;
+	
+	counters->isr_entries++;
+	if(rx_bytes + tx_bytes > counters->max_bytes_per_entry)
+	{
+		counters->max_bytes_per_entry = rx_bytes + tx_bytes;
+	}
+	#endif
 }
 
 void UART0_Handler(void)
@@ -438,46 +1250,260 @@ void USART2_Handler(void)
 {
 	handle_usart_interrupt((usart_if)USART2, USART2_pointer);
 }
+
+void XDMAC_Handler(void)
+{
+	for(uint8_t i = 0; i < NUMBER_OF_UART; i++)
+	{
+		// Reception has gone back to the beginning of the ring : its interrupt publishes the bytes at least once per lap
+		if((serial_mdw_buffer[i].dma_mode & DMA_RX_USED) && serial_dma_rx_wrapped(XDMAC, SERIAL_MDW_DMA_RX_CHANNEL(i)))
+		{
+			serial_mdw_buffer[i].dma_rx_laps++;
+			#if defined(TEST)
+			serial_mdw_rx_received(i, serial_mdw_dma_rx_sync(i));
+			#else
+			NVIC_SetPendingIRQ(serial_mdw_port[i].irq);
+			#endif
+		}
+		if((serial_mdw_buffer[i].dma_mode & DMA_TX_USED) && serial_dma_tx_completed(XDMAC, SERIAL_MDW_DMA_TX_CHANNEL(i)))
+		{
+			serial_mdw_dma_tx_complete(i);
+		}
+	}
+}
+	
+void serial_mdw_dma_rx_start(UART_pointer_t uart_pointer, volatile const void *p_rhr)
+{
+	circ_bbuf_t *buffer_rx = &serial_mdw_buffer[uart_pointer].buffer_rx;
 	
+	serial_mdw_buffer[uart_pointer].dma_rx_position = 0;
+	serial_mdw_buffer[uart_pointer].dma_rx_laps = 0;
+	serial_mdw_buffer[uart_pointer].dma_rx_overrun = 0;
+	pmc_enable_periph_clk(ID_XDMAC);
+	serial_dma_rx_start(XDMAC, SERIAL_MDW_DMA_RX_CHANNEL(uart_pointer), serial_mdw_port[uart_pointer].dma_rx_id, p_rhr,
+						buffer_rx->buffer, buffer_rx->capacity, &serial_mdw_buffer[uart_pointer].dma_rx_descriptor);
+	if(serial_mdw_port[uart_pointer].type == SERIAL_MDW_UART)
+	{
+		serial_mdw_dma_rx_polled |= 1UL << uart_pointer;
+	}
+	#if !defined(TEST)
+	NVIC_ClearPendingIRQ(XDMAC_IRQn);
+	NVIC_EnableIRQ(XDMAC_IRQn);
+	#endif
+}
+
+uint32_t serial_mdw_dma_rx_sync(UART_pointer_t uart_pointer)
+{
+	circ_bbuf_t *buffer_rx = &serial_mdw_buffer[uart_pointer].buffer_rx;
+	uint32_t position = serial_dma_rx_position(XDMAC, SERIAL_MDW_DMA_RX_CHANNEL(uart_pointer), buffer_rx->capacity);
+	uint32_t start = buffer_rx->head % buffer_rx->capacity;
+	uint32_t received = (position + buffer_rx->capacity - serial_mdw_buffer[uart_pointer].dma_rx_position) % buffer_rx->capacity;
+	uint32_t free_space = circ_bbuf_available_space(buffer_rx);
+	int32_t laps = serial_mdw_buffer[uart_pointer].dma_rx_laps;
+	
+	// Ends of the ring seen by the XDMAC interrupt are balanced by the wraps of the position, a wrap seen before its interrupt is carried
+	if(position < serial_mdw_buffer[uart_pointer].dma_rx_position) laps--;
+	serial_mdw_buffer[uart_pointer].dma_rx_laps = (laps < 0) ? laps : 0;
+	serial_mdw_buffer[uart_pointer].dma_rx_position = position;
+	
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	// Bytes of the frame in progress aren't published yet
+	if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+	{
+		start = serial_mdw_buffer[uart_pointer].frames.write % buffer_rx->capacity;
+		free_space = buffer_rx->capacity - (serial_mdw_buffer[uart_pointer].frames.write - buffer_rx->tail);
+	}
+	#endif
+	
+	// DMA doesn't wait for the reader : once it has written over unread bytes, nothing is published until the reader drops them
+	if(laps > 0 || received > free_space || serial_mdw_buffer[uart_pointer].dma_rx_overrun)
+	{
+		if(!serial_mdw_buffer[uart_pointer].dma_rx_overrun)
+		{
+			serial_mdw_buffer[uart_pointer].stats.overrun_errors++;
+			serial_mdw_buffer[uart_pointer].dma_rx_overrun = SERIAL_MDW_DMA_RX_OVERRUN;
+			// Reader is woken up to drop them
+			serial_mdw_rx_notify(uart_pointer);
+		}else if(received != 0)
+		{
+			serial_mdw_buffer[uart_pointer].dma_rx_overrun = SERIAL_MDW_DMA_RX_OVERRUN;
+		}
+		// A lap missed by the position is a whole ring of bytes
+		serial_mdw_buffer[uart_pointer].stats.rx_dropped += received + ((laps > 0) ? (uint32_t)laps * buffer_rx->capacity : 0);
+		return received;
+	}
+	
+	// Lines written by the DMA since the last synchronization are dropped from the cache before being published
+	if(position >= start)
+	{
+		serial_dma_invalidate_dcache(&buffer_rx->buffer[start], position - start);
+	}else
+	{
+		serial_dma_invalidate_dcache(&buffer_rx->buffer[start], buffer_rx->capacity - start);
+		serial_dma_invalidate_dcache(buffer_rx->buffer, position);
+	}
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	// Bytes are added to the frame in progress, closed by the receiver time-out, and timestamped when its first bytes are seen
+	if(serial_mdw_buffer[uart_pointer].timestamp_activated == TIMESTAMP_USED)
+	{
+		frame_queue_t *frames = &serial_mdw_buffer[uart_pointer].frames;
+		uint32_t published = fq_advance_to(frames, position);
+		
+		if(published != 0 && fq_pending_length(frames) == published)
+		{
+			fq_set_timestamp(frames, timebase_unix_us());
+		}
+		if(published < received)
+		{
+			serial_mdw_buffer[uart_pointer].stats.rx_dropped += received - published;
+		}
+	}else
+	#endif
+	{
+		circ_bbuf_advance_head_to(buffer_rx, position);
+	}
+	return received;
+}
+
+// Bytes left unread when the DMA overran the reader are dropped, reception restarts from the DMA position
+static void serial_mdw_dma_rx_resync(UART_pointer_t uart_pointer)
+{
+	serial_mdw_buffer_t *port = &serial_mdw_buffer[uart_pointer];
+	irqflags_t flags;
+	
+	if(!port->dma_rx_overrun) return;
+	
+	flags = SERIAL_MDW_LOCK();
+	#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
+	// Frames queued may have been written over, the frame in progress goes on after the lost bytes : none of them is given
+	if(port->timestamp_activated == TIMESTAMP_USED)
+	{
+		port->stats.frames_dropped += fq_available_frames(&port->frames);
+		port->stats.rx_dropped += port->frames.write - port->buffer_rx.tail;
+		fq_reset_to(&port->frames, port->dma_rx_position, port->dma_rx_overrun == SERIAL_MDW_DMA_RX_OVERRUN);
+	}else
+	#endif
+	{
+		port->stats.rx_dropped += circ_bbuf_available_bytes_to_read(&port->buffer_rx);
+		circ_bbuf_reset_to(&port->buffer_rx, port->dma_rx_position);
+	}
+	port->dma_rx_overrun = 0;
+	SERIAL_MDW_UNLOCK(flags);
+	serial_mdw_ready_update(uart_pointer);
+}
+
+void serial_mdw_dma_rx_refresh(UART_pointer_t uart_pointer)
+{
+	if(serial_mdw_buffer[uart_pointer].dma_mode & DMA_RX_USED)
+	{
+		serial_mdw_dma_rx_resync(uart_pointer);
+		// Interrupt handler stays the only producer of the RX buffer : it is triggered to publish the DMA position
+		#if defined(TEST)
+		serial_mdw_rx_received(uart_pointer, serial_mdw_dma_rx_sync(uart_pointer));
+		#else
+		NVIC_SetPendingIRQ(serial_mdw_port[uart_pointer].irq);
+		__DSB();
+		__ISB();
+		#endif
+	}
+}
+
+void serial_mdw_dma_tx_init(UART_pointer_t uart_pointer, volatile void *p_thr)
+{
+	serial_mdw_buffer[uart_pointer].dma_thr = p_thr;
+	serial_mdw_buffer[uart_pointer].dma_tx_state = DMA_TX_IDLE;
+	
+	pmc_enable_periph_clk(ID_XDMAC);
+	#if !defined(TEST)
+	NVIC_ClearPendingIRQ(XDMAC_IRQn);
+	NVIC_EnableIRQ(XDMAC_IRQn);
+	#endif
+}
+
+void serial_mdw_dma_tx_kick(UART_pointer_t uart_pointer)
+{
+	serial_mdw_buffer_t *port = &serial_mdw_buffer[uart_pointer];
+	uint8_t *data;
+	uint32_t length;
+	irqflags_t flags = SERIAL_MDW_LOCK();
+	
+	// Transfer in progress : the next part of the TX buffer is sent from its completion.
+	// Channel is claimed with the interrupts masked, a kick from an interrupt can't start a second transfer
+	if(port->dma_tx_state != DMA_TX_IDLE)
+	{
+		SERIAL_MDW_UNLOCK(flags);
+		return;
+	}
+	length = circ_bbuf_peek_contiguous(&port->buffer_tx, &data);
+	if(length != 0)
+	{
+		port->dma_tx_length = length;
+		port->dma_tx_state = DMA_TX_RING;
+	}
+	SERIAL_MDW_UNLOCK(flags);
+	if(length == 0) return;
+	
+	serial_dma_tx_start(XDMAC, SERIAL_MDW_DMA_TX_CHANNEL(uart_pointer), serial_mdw_port[uart_pointer].dma_tx_id, port->dma_thr, data, length);
+}
+
+void serial_mdw_dma_tx_complete(UART_pointer_t uart_pointer)
+{
+	serial_mdw_buffer_t *port = &serial_mdw_buffer[uart_pointer];
+	UART_dma_tx_state_t state = port->dma_tx_state;
+	
+	port->dma_tx_state = DMA_TX_IDLE;
+	port->stats.tx_bytes += port->dma_tx_length;
+	if(state == DMA_TX_RING)
+	{
+		circ_bbuf_skip(&port->buffer_tx, port->dma_tx_length);
+	}
+	else if(state == DMA_TX_BUFFER && port->dma_tx_callback != NULL)
+	{
+		// Callback can already give the next buffer to send
+		port->dma_tx_callback(port->dma_tx_context);
+	}
+	serial_mdw_dma_tx_kick(uart_pointer);
+}
+
+#if defined(TEST)
+void serial_mdw_test_reset(void)
+{
+	// Every interface is back to not initialized, its storage is given again by serial_mdw_init_interface
+	memset(serial_mdw_buffer, 0, sizeof(serial_mdw_buffer));
+	serial_mdw_rx_events = 0;
+	serial_mdw_ready = 0;
+	serial_mdw_dma_rx_polled = 0;
+	serial_mdw_rx_waiting = 0;
+	serial_mdw_ready_last = NUMBER_OF_UART - 1;
+}
+#endif
+
 UART_pointer_t uart_buffer_from_UART(usart_if p_usart){
 		
 	UART_pointer_t uart_buffer = UART0_pointer;
-		
-	if((Uart*)UART0 == (Uart*)p_usart){
-		uart_buffer = UART0_pointer;
-	}else if((Uart*)UART1 == (Uart*)p_usart){
-		uart_buffer = UART1_pointer;
-	}else if((Uart*)UART2 == (Uart*)p_usart){
-		uart_buffer = UART2_pointer;
-	}else if((Uart*)UART3 == (Uart*)p_usart){
-		uart_buffer = UART3_pointer;
-	}else if((Uart*)UART4 == (Uart*)p_usart){
-		uart_buffer = UART4_pointer;
-	}else if((Usart*)USART0 == (Usart*)p_usart){
-		uart_buffer = USART0_pointer;
-	}else if((Usart*)USART1 == (Usart*)p_usart){
-		uart_buffer = USART1_pointer;
-	}else if((Usart*)USART2 == (Usart*)p_usart){
-		uart_buffer = USART2_pointer;
-	};
+	
+	// Only used at initialization, NUMBER_OF_UART is given back for an unknown UART/USART
+	while(uart_buffer < NUMBER_OF_UART && serial_mdw_port[uart_buffer].p_usart != p_usart)
+	{
+		uart_buffer++;
+	}
 		
 	return uart_buffer;
 }
+
+static inline uint8_t serial_mdw_handle_is_valid(serial_mdw_handle_t handle)
+{
+	return handle.slot < NUMBER_OF_UART
+		&& serial_mdw_port[handle.slot].p_usart == handle.p_usart
+		&& serial_mdw_port[handle.slot].type == handle.type
+		&& serial_mdw_buffer[handle.slot].status == INITIALIZED;
+}
 	
 	/// @cond 0
 	/**INDENT-OFF**/
 	#ifdef __cplusplus
 }
 #endif
-/**
- * \brief Handler for System Tick interrupt.
- *
- * Process System Tick Event and increments the ul_ms_ticks counter.
- */
-void SysTick_Handler(void)
-{
-	unix_timestamp_ms++;
-}
 /**INDENT-ON**/
 /// @endcond
 
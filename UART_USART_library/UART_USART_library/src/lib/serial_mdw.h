@@ -51,8 +51,9 @@ LICENSE:
 
 #include "status_codes.h"
 #include "uart_serial.h"
+#include "serial_framing.h"
 #include "utils/circular-byte-buffer.h"
-#include "utils/timestamp-buffer.h"
+#include "utils/frame-queue.h"
 
 /*
    +========================================+
@@ -61,31 +62,107 @@ LICENSE:
 */
 
 #define SERIAL_MDW_TIMESTAMP_ACTIVATED
+// Define to take buffers from statically sized arrays instead of the heap
+#define SERIAL_MDW_STATIC_BUFFERS
+// Define to count interrupt entries and the peak number of bytes moved by one entry
+#define SERIAL_MDW_ISR_COUNTERS
 
 #define SERIAL_MDW_BUFFER_SIZE 256
-#define SERIAL_MDW_BUFFER_TIMESTAMP_SIZE 20
+// Frames of a timestamped interface waiting to be read
+#define SERIAL_MDW_BUFFER_TIMESTAMP_SIZE 32
+
+// Frame delimiter used by timestamped interfaces until serial_mdw_set_framing is called
+#define SERIAL_MDW_DEFAULT_DELIMITER 'E'
+
+// Longest time-out of the RX watermarks, the time since the last read is kept on 32 bits of microseconds
+#define SERIAL_MDW_RX_TIMEOUT_MAX_MS 3600000
+
+// Receiver time-out (in bit periods) flushing a partial frame received by DMA on USARTs, closing the frame with timestamp
+#define SERIAL_MDW_DMA_RX_TIMEOUT 20
+
+// Default buffer sizes, used when conf_uart_serial.h doesn't provide SERIAL_MDW_CONF_BUFFERS
+#if !defined(SERIAL_MDW_CONF_BUFFERS)
+#	define SERIAL_MDW_CONF_BUFFERS(BUFFER)                                                       \
+	BUFFER(uart0,   SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE) \
+	BUFFER(uart1,   SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE) \
+	BUFFER(uart2,   SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE) \
+	BUFFER(uart3,   SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE) \
+	BUFFER(uart4,   SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE) \
+	BUFFER(usart0,  SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE) \
+	BUFFER(usart1,  SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE) \
+	BUFFER(usart2,  SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_SIZE, SERIAL_MDW_BUFFER_TIMESTAMP_SIZE)
+#endif
+
+#if (SERIAL_MDW_BUFFER_SIZE & (SERIAL_MDW_BUFFER_SIZE - 1)) != 0
+#	error "SERIAL_MDW_BUFFER_SIZE must be a power of two"
+#endif
+#if (SERIAL_MDW_BUFFER_TIMESTAMP_SIZE & (SERIAL_MDW_BUFFER_TIMESTAMP_SIZE - 1)) != 0
+#	error "SERIAL_MDW_BUFFER_TIMESTAMP_SIZE must be a power of two"
+#endif
+
+// Reception errors seen while receiving a timestamped frame
+#define SERIAL_MDW_FRAME_OVERRUN	0x01
+#define SERIAL_MDW_FRAME_FRAMING	0x02
+#define SERIAL_MDW_FRAME_PARITY		0x04
 
 typedef enum {
 	TIMESTAMP_USED,
 	TIMESTAMP_NOT_USED
 } UART_timestamp_t;
 
-#ifdef SERIAL_MDW_TIMESTAMP_ACTIVATED
-typedef struct serial_mdw_data_timestamp_t {
-	uint8_t *data;
-	uint32_t length;
-	uint64_t timestamp;
-} serial_mdw_data_timestamp_t;
-#endif
+typedef enum {
+	DMA_NOT_USED = 0,
+	DMA_RX_USED = 1,
+	DMA_TX_USED = 2,
+	DMA_RX_TX_USED = 3
+} UART_dma_t;
 
-/*
-   +========================================+
-				Global Variables						
-   +========================================+
-*/
+typedef enum {
+	SERIAL_MDW_UART,
+	SERIAL_MDW_USART
+} serial_mdw_type_t;
 
-static const uint8_t char_to_compare_for_timestamp = 'E';
-static volatile uint64_t unix_timestamp_ms = 0UL;
+// Interface descriptor given by serial_mdw_init_interface and used by all the other calls
+typedef struct serial_mdw_handle_t {
+	usart_if	p_usart;
+	uint8_t		slot;
+	uint8_t		type;		// serial_mdw_type_t
+} serial_mdw_handle_t;
+
+#define SERIAL_MDW_HANDLE_INVALID	((serial_mdw_handle_t){.p_usart = NULL, .slot = 0xFF, .type = SERIAL_MDW_UART})
+
+// Called from the XDMAC interrupt once a buffer given to serial_mdw_send_buffer has been sent
+typedef void (*serial_mdw_tx_callback_t)(void *context);
+// Called from the interrupt of an interface when a frame is complete (timestamp) or when bytes are received (no timestamp)
+typedef void (*serial_mdw_rx_callback_t)(serial_mdw_handle_t handle, void *context);
+
+// Statistics of an interface, always counted : only a few increments per interrupt entry
+typedef struct serial_mdw_stats_t {
+	uint32_t rx_bytes;				// bytes received
+	uint32_t tx_bytes;				// bytes sent
+	uint32_t rx_dropped;			// bytes received while the RX buffer was full
+	uint32_t overrun_errors;		// hardware overrun, bytes lost before being read
+	uint32_t framing_errors;
+	uint32_t parity_errors;
+	uint32_t rx_high_water;			// peak number of bytes waiting in the RX buffer
+	uint32_t frames_timestamped;
+	uint32_t frames_dropped;		// timestamped frames dropped whole because the RX buffer or the frame descriptors were full
+} serial_mdw_stats_t;
+
+#if defined(SERIAL_MDW_ISR_COUNTERS)
+typedef struct serial_mdw_isr_counters_t {
+	uint32_t isr_entries;
+	uint32_t max_bytes_per_entry;
+} serial_mdw_isr_counters_t;
+#endif
+
+// Frame read in place from the RX buffer, second part is only used when the frame wraps around the end of the buffer
+typedef struct serial_mdw_frame_t {
+	const uint8_t *data[2];
+	uint32_t length[2];
+	uint64_t timestamp;		// Unix time in microseconds (timebase.h)
+	uint8_t errors;			// SERIAL_MDW_FRAME_xxx, 0 without timestamp
+} serial_mdw_frame_t;
 
 /*
    +========================================+
@@ -99,82 +176,201 @@ static volatile uint64_t unix_timestamp_ms = 0UL;
 * @param p_usart : UARTx/USARTx
 * @param opt : parameters
 * @param activate_timestamp : activate timestamp, only works if SERIAL_MDW_TIMESTAMP_ACTIVATED is defined
-* @return none
+* @param dma_mode : reception/transmission through XDMAC, reception needs SERIAL_MDW_STATIC_BUFFERS,
+* with timestamp it is only available on USARTs and frames are closed by the receiver time-out (SERIAL_FRAMING_IDLE)
+* Buffer sizes are taken from SERIAL_MDW_CONF_BUFFERS (conf_uart_serial.h)
+* @param p_handle : handle of the interface, SERIAL_MDW_HANDLE_INVALID on error
+* @return STATUS_OK, ERR_BUSY if already initialized (p_handle is still given), ERR_NO_MEMORY if buffers can't be allocated,
+* ERR_INVALID_ARG if p_usart is unknown or opt/p_handle is NULL, ERR_INVALID_ARG/ERR_UNSUPPORTED_DEV if the DMA mode can't be used
 */
-extern void serial_mdw_init_interface(usart_if p_usart, const usart_serial_options_t *opt, UART_timestamp_t activate_timestamp) ;
+extern status_code_t serial_mdw_init_interface(usart_if p_usart, const usart_serial_options_t *opt, UART_timestamp_t activate_timestamp, UART_dma_t dma_mode, serial_mdw_handle_t *p_handle) ;
 /**
 * Send a byte through the given UART/USART
-* @param p_usart : UART/USART
+* @param handle : UART/USART handle
 * @param c : byte to send
-* @return none
+* @return STATUS_OK, ERR_NO_MEMORY if TX buffer is full, ERR_INVALID_ARG if handle is invalid
 */
-extern uint8_t serial_mdw_send_byte(usart_if p_usart, const uint8_t data);
+extern status_code_t serial_mdw_send_byte(serial_mdw_handle_t handle, const uint8_t data);
 /**
 * Send multiples bytes through the given UART/USART
-* @param p_usart : UARTx/USARTx
+* @param handle : UARTx/USARTx handle
 * @param p_buff : pointer to the buffer of bytes
 * @param ulsize : size of the buffer of bytes
-* @return none
+* @return STATUS_OK, ERR_NO_MEMORY if TX buffer is full (remaining bytes dropped), ERR_INVALID_ARG if handle is invalid
 */
-extern uint8_t serial_mdw_send_bytes(usart_if p_usart, const uint8_t *p_buff, uint32_t ulsize);
+extern status_code_t serial_mdw_send_bytes(serial_mdw_handle_t handle, const uint8_t *p_buff, uint32_t ulsize);
 /**
-* Check if UART/USART has some data in it to be read
+* Send a buffer owned by the caller through the given UART/USART by DMA, without copy
+* Interface has to be initialized with DMA_TX_USED
+* @param handle : UARTx/USARTx handle
+* @param p_buff : pointer to the buffer of bytes, has to stay untouched until callback is called
+* @param ulsize : size of the buffer of bytes
+* @param callback : called from interrupt at the end of the transfer, can be NULL
+* @param context : given back to the callback
+* @return STATUS_OK, ERR_BUSY if a transfer is in progress, ERR_INVALID_ARG (also for an invalid handle), ERR_UNSUPPORTED_DEV if DMA isn't used
+*/
+extern status_code_t serial_mdw_send_buffer(serial_mdw_handle_t handle, const uint8_t *p_buff, uint32_t ulsize, serial_mdw_tx_callback_t callback, void *context);
+/**
+* Check if UART/USART has some data in it to be read, the mask is kept up to date by the interrupts
 * @param none
-* @return byte and LSB is UART0, MSB is USART2, mask to be used to determine wich UART/USART has data
+* @return bit i is set when the interface of slot i (handle.slot) has data : LSB is UART0, bit 7 is USART2
+*/
+extern uint32_t serial_mdw_available(void);
+/**
+* Give the next UART/USART which has some data to be read, interfaces are given in turn
+* Its bit is cleared once everything has been read from it
+* @param p_handle : handle of the interface
+* @return true if an interface has data, false otherwise (p_handle is untouched)
 */
-extern uint8_t serial_mdw_available(void);
+extern uint8_t serial_mdw_next_ready(serial_mdw_handle_t *p_handle);
+/**
+* Call a function from the interrupt of the UART/USART each time something can be read, replaced on each call
+* A frame is notified when it is complete with timestamp, otherwise once per interrupt entry having received bytes
+* @param handle : UARTx/USARTx handle
+* @param callback : called from interrupt, has to be short, NULL to stop
+* @param context : given back to the callback
+* @return STATUS_OK, ERR_INVALID_ARG if handle is invalid
+*/
+extern status_code_t serial_mdw_set_rx_callback(serial_mdw_handle_t handle, serial_mdw_rx_callback_t callback, void *context);
+/**
+* Batch the reception of an UART/USART without timestamp : it is notified (ready mask, event, callback) once when
+* bytes are available in its RX buffer, or once data has waited timeout_ms since it was received or last read
+* The notification comes back after a read leaving the RX buffer below the watermark
+* @param handle : UARTx/USARTx handle
+* @param bytes : level of the RX buffer, 0 with timeout_ms = 0 notifies every interrupt entry having received bytes (default)
+* @param timeout_ms : longest wait below the watermark, 0 to wait for the watermark only
+* @return STATUS_OK, ERR_INVALID_ARG if handle is invalid or a value is too big, ERR_UNSUPPORTED_DEV with timestamp
+*/
+extern status_code_t serial_mdw_set_rx_watermark(serial_mdw_handle_t handle, uint32_t bytes, uint32_t timeout_ms);
+/**
+* Give the UARTs/USARTs notified since the last call, without waiting
+* @param none
+* @return mask of the events, same bits as serial_mdw_available (bit i is the slot i of the handles)
+*/
+extern uint32_t serial_mdw_take_rx_events(void);
+/**
+* Sleep (WFI) until an UART/USART is notified, any other interrupt lets the core go back to sleep
+* Frames received before the call are given at once : the reader has to read everything of the notified interfaces
+* @param none
+* @return mask of the events, same bits as serial_mdw_available (bit i is the slot i of the handles)
+*/
+extern uint32_t serial_mdw_wait_rx_events(void);
 /**
 * Return the number of available bytes for the designed UART/USART
-* @param p_usart : UARTx/USARTx
-* @return number of bytes that can be read from the buffer
+* @param handle : UARTx/USARTx handle
+* @return number of bytes that can be read from the buffer, 0 if handle is invalid
 */
-extern uint32_t serial_mdw_available_bytes(usart_if p_usart);
+extern uint32_t serial_mdw_available_bytes(serial_mdw_handle_t handle);
 /**
 * Read the byte in the given UART/USART
-* @param p_usart : UARTx/USARTx
+* @param handle : UARTx/USARTx handle
 * @param data : pointer to the data
 * @return status of the read
 */
-extern uint8_t serial_mdw_read_byte(usart_if p_usart, uint8_t *data);
+extern uint8_t serial_mdw_read_byte(serial_mdw_handle_t handle, uint8_t *data);
 /**
 * Read the byte in the given UART/USART
-* @param p_usart : UARTx/USARTx
+* @param handle : UARTx/USARTx handle
 * @param p_buff : pointer to the buffer of bytes
 * @param ulsize : size of the buffer of bytes that has to be read
 * @return status of the read
 */
-extern uint8_t serial_mdw_read_bytes(usart_if p_usart, uint8_t *p_buff, uint32_t ulsize);
+extern uint8_t serial_mdw_read_bytes(serial_mdw_handle_t handle, uint8_t *p_buff, uint32_t ulsize);
+
+/**
+* Give the statistics of the designed UART/USART, counted since its initialization
+* @param handle : UARTx/USARTx handle
+* @param stats : pointer to the statistics copy
+* @return STATUS_OK, ERR_INVALID_ARG if handle is invalid
+*/
+extern status_code_t serial_mdw_get_stats(serial_mdw_handle_t handle, serial_mdw_stats_t *stats);
+
+#if defined(SERIAL_MDW_ISR_COUNTERS)
+/**
+* Give the interrupt counters of the designed UART/USART, bytes per entry is (stats.rx_bytes + stats.tx_bytes) / isr_entries
+* @param handle : UARTx/USARTx handle
+* @param counters : pointer to the counters copy
+* @return STATUS_OK, ERR_INVALID_ARG if handle is invalid
+*/
+extern status_code_t serial_mdw_get_isr_counters(serial_mdw_handle_t handle, serial_mdw_isr_counters_t *counters);
+#endif
 
 #if defined(SERIAL_MDW_TIMESTAMP_ACTIVATED)
 /**
 * Return the number of data timestamped for the designed UART/USART
-* @param p_usart : UARTx/USARTx
-* @return number of data that can be read from the buffer
+* @param handle : UARTx/USARTx handle
+* @return number of data that can be read from the buffer, 0 if handle is invalid
 */
-extern uint32_t serial_mdw_timestamp_available(usart_if p_usart);
+extern uint32_t serial_mdw_timestamp_available(serial_mdw_handle_t handle);
 /**
-* Read the a frame received
-* @param p_usart : UARTx/USARTx
-* @param data_timestamp : pointer to a data_timestamp structure
-* @return status of the read
+* Change how frames are detected on a timestamped UART/USART, a frame in progress is kept
+* SERIAL_FRAMING_IDLE uses the receiver time-out of USARTs, idle_bits is its value in bit periods,
+* it is the only framing of interfaces receiving by DMA, whose frames are timestamped when their first bytes are published
+* @param handle : UARTx/USARTx handle
+* @param conf : framing configuration, copied
+* @return STATUS_OK, ERR_INVALID_ARG if handle or configuration is invalid,
+* ERR_UNSUPPORTED_DEV without timestamp, for SERIAL_FRAMING_IDLE on a UART or for another framing with DMA reception
 */
-extern uint8_t serial_mdw_timestamp_read(usart_if p_usart, serial_mdw_data_timestamp_t *data_timestamp);
+extern status_code_t serial_mdw_set_framing(serial_mdw_handle_t handle, const serial_framing_conf_t *conf);
 #endif
 
+/**
+* Copy the next frame received into a buffer of the caller
+* Without timestamp, a frame is every byte received, up to capacity
+* @param handle : UARTx/USARTx handle
+* @param p_buff : pointer to the buffer of bytes
+* @param capacity : size of the buffer of bytes
+* @param p_length : length of the frame, 0 if nothing has been received
+* @param p_timestamp : timestamp of the frame in microseconds (0 without timestamp), can be NULL
+* @return STATUS_OK, ERR_NO_MEMORY if the frame is bigger than capacity (frame is kept, p_length is its length), ERR_INVALID_ARG if handle is invalid
+*/
+extern status_code_t serial_mdw_frame_read(serial_mdw_handle_t handle, uint8_t *p_buff, uint32_t capacity, uint32_t *p_length, uint64_t *p_timestamp);
+/**
+* Give the next frame received in place, without copy, it stays in the RX buffer until serial_mdw_frame_commit
+* Without timestamp, a frame is every byte received
+* @param handle : UARTx/USARTx handle
+* @param frame : pointer to the frame, total length 0 if nothing has been received
+* @return STATUS_OK, ERR_INVALID_ARG if handle is invalid
+*/
+extern status_code_t serial_mdw_frame_peek(serial_mdw_handle_t handle, serial_mdw_frame_t *frame);
+/**
+* Release the frame given by serial_mdw_frame_peek
+* @param handle : UARTx/USARTx handle
+* @param frame : pointer to the frame given by serial_mdw_frame_peek
+* @return STATUS_OK, ERR_INVALID_ARG if handle is invalid
+*/
+extern status_code_t serial_mdw_frame_commit(serial_mdw_handle_t handle, const serial_mdw_frame_t *frame);
+
 // Allow to use CMock to mock this library by removing 'extern' keyword
 #elif defined (TEST)
-void serial_mdw_init_interface(usart_if p_usart, const usart_serial_options_t *opt, UART_timestamp_t activate_timestamp) ;
-uint8_t serial_mdw_send_byte(usart_if p_usart, const uint8_t data);
-uint8_t serial_mdw_send_bytes(usart_if p_usart, const uint8_t *p_buff, uint32_t ulsize);
-uint8_t serial_mdw_available(void);
-uint32_t serial_mdw_available_bytes(usart_if p_usart);
-uint8_t serial_mdw_read_byte(usart_if p_usart, uint8_t *data);
-uint8_t serial_mdw_read_bytes(usart_if p_usart, uint8_t *p_buff, uint32_t ulsize);
+status_code_t serial_mdw_init_interface(usart_if p_usart, const usart_serial_options_t *opt, UART_timestamp_t activate_timestamp, UART_dma_t dma_mode, serial_mdw_handle_t *p_handle) ;
+status_code_t serial_mdw_send_byte(serial_mdw_handle_t handle, const uint8_t data);
+status_code_t serial_mdw_send_bytes(serial_mdw_handle_t handle, const uint8_t *p_buff, uint32_t ulsize);
+status_code_t serial_mdw_send_buffer(serial_mdw_handle_t handle, const uint8_t *p_buff, uint32_t ulsize, serial_mdw_tx_callback_t callback, void *context);
+uint32_t serial_mdw_available(void);
+uint8_t serial_mdw_next_ready(serial_mdw_handle_t *p_handle);
+status_code_t serial_mdw_set_rx_callback(serial_mdw_handle_t handle, serial_mdw_rx_callback_t callback, void *context);
+status_code_t serial_mdw_set_rx_watermark(serial_mdw_handle_t handle, uint32_t bytes, uint32_t timeout_ms);
+uint32_t serial_mdw_take_rx_events(void);
+uint32_t serial_mdw_wait_rx_events(void);
+uint32_t serial_mdw_available_bytes(serial_mdw_handle_t handle);
+uint8_t serial_mdw_read_byte(serial_mdw_handle_t handle, uint8_t *data);
+uint8_t serial_mdw_read_bytes(serial_mdw_handle_t handle, uint8_t *p_buff, uint32_t ulsize);
+status_code_t serial_mdw_get_stats(serial_mdw_handle_t handle, serial_mdw_stats_t *stats);
+
+#if defined(SERIAL_MDW_ISR_COUNTERS)
+status_code_t serial_mdw_get_isr_counters(serial_mdw_handle_t handle, serial_mdw_isr_counters_t *counters);
+#endif
 
 #if defined(SERIAL_MDW_TIMESTAMP_ACTIVATED)
-uint32_t serial_mdw_timestamp_available(usart_if p_usart);
-uint8_t serial_mdw_timestamp_read(usart_if p_usart, serial_mdw_data_timestamp_t *data_timestamp);
+uint32_t serial_mdw_timestamp_available(serial_mdw_handle_t handle);
+status_code_t serial_mdw_set_framing(serial_mdw_handle_t handle, const serial_framing_conf_t *conf);
 #endif
+status_code_t serial_mdw_frame_read(serial_mdw_handle_t handle, uint8_t *p_buff, uint32_t capacity, uint32_t *p_length, uint64_t *p_timestamp);
+status_code_t serial_mdw_frame_peek(serial_mdw_handle_t handle, serial_mdw_frame_t *frame);
+status_code_t serial_mdw_frame_commit(serial_mdw_handle_t handle, const serial_mdw_frame_t *frame);
+// Forget every interface and event, to start each test from the state after reset
+void serial_mdw_test_reset(void);
 #endif
 
 #endif /* SERIAL_MDW_H_ */
\ No newline at end of file
@@ -0,0 +1,278 @@
+/*
+   +========================================+
+				Includes
+   +========================================+
+*/
+#include "timebase.h"
+
+#include <stddef.h>
+
+/*
+   +========================================+
+				Defines
+   +========================================+
+*/
+
+// Writers (timebase_tick from SysTick, set_epoch, the discipline from the SQW interrupt or the main loop) can preempt
+// each other : each one masks the interrupts while it copies, advances and publishes a slot
+#if defined(TEST)
+#	define TIMEBASE_LOCK()			(0)
+#	define TIMEBASE_UNLOCK(flags)	((void)(flags))
+#else
+#	define TIMEBASE_LOCK()			cpu_irq_save()
+#	define TIMEBASE_UNLOCK(flags)	cpu_irq_restore(flags)
+#endif
+
+#define TIMEBASE_LOAD(x)		__atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define TIMEBASE_STORE(x, v)	__atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+// Key unlocking the DWT registers of the Cortex-M7
+#define TIMEBASE_DWT_LAR_KEY	0xC5ACCE55
+
+// Rate correction is a fraction of 2^32 added to every microsecond
+#define TIMEBASE_RATE_SHIFT		32
+
+typedef struct timebase_slot_t {
+	uint64_t	base_us;		// microseconds counted up to base_counter
+	uint32_t	base_counter;
+	uint64_t	epoch_us;
+	int32_t		rate;			// correction per microsecond, in 2^-32
+	int64_t		rate_remainder;	// correction not counted yet in base_us, in 2^-32 of microsecond
+} timebase_slot_t;
+
+// State of the clock discipline, updated with the interrupts masked
+typedef struct timebase_discipline_t {
+	uint8_t		synchronized;
+	uint64_t	reference_us;	// last reference time
+	int32_t		drift_ppb;		// estimated frequency error of the counter
+	uint8_t		pps_rejected;	// edges rejected in a row by timebase_discipline_pps
+} timebase_discipline_t;
+
+/*
+   +========================================+
+				Global Variables
+   +========================================+
+*/
+
+#if defined(TEST)
+volatile uint32_t timebase_test_counter = 0;
+void (*timebase_test_read_hook)(void) = NULL;
+#endif
+
+// Time base shared by every reader : the writer fills the slot which isn't read then publishes it by incrementing
+// the sequence. A reader preempting the writer keeps reading the published slot, a reader preempted by a write retries.
+static timebase_slot_t timebase_slot[2];
+static volatile uint32_t timebase_sequence = 0;
+static uint32_t cycles_per_us = 1;
+static timebase_discipline_t timebase_discipline_state;
+
+/*
+   +========================================+
+				Internal functions definition
+   +========================================+
+*/
+static void timebase_read(timebase_slot_t *slot)
+{
+	uint32_t sequence;
+
+	do {
+		sequence = TIMEBASE_LOAD(timebase_sequence);
+		#if defined(TEST)
+		if(timebase_test_read_hook != NULL) timebase_test_read_hook();
+		#endif
+		*slot = timebase_slot[sequence & 1];
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while(sequence != TIMEBASE_LOAD(timebase_sequence));
+}
+
+// Time of a slot, corrected by its rate
+static inline uint64_t timebase_slot_us(const timebase_slot_t *slot, uint32_t counter)
+{
+	uint32_t elapsed_us = (counter - slot->base_counter) / cycles_per_us;
+
+	return slot->base_us + elapsed_us + ((slot->rate_remainder + (int64_t)elapsed_us * slot->rate) >> TIMEBASE_RATE_SHIFT);
+}
+
+// Move the base of a slot up to counter : rate can then be changed without modifying the past
+static void timebase_slot_advance(timebase_slot_t *slot, uint32_t counter)
+{
+	// Only 32 bits divisions : elapsed cycles are less than a counter lap
+	uint32_t elapsed_us = (counter - slot->base_counter) / cycles_per_us;
+	int64_t correction = slot->rate_remainder + (int64_t)elapsed_us * slot->rate;
+	int64_t correction_us = correction >> TIMEBASE_RATE_SHIFT;
+
+	slot->base_counter += elapsed_us * cycles_per_us;
+	slot->base_us += elapsed_us + correction_us;
+	slot->rate_remainder = correction - (correction_us << TIMEBASE_RATE_SHIFT);
+}
+
+static int32_t timebase_clamp_ppb(int64_t ppb)
+{
+	if(ppb > TIMEBASE_MAX_SLEW_PPB) return TIMEBASE_MAX_SLEW_PPB;
+	if(ppb < -TIMEBASE_MAX_SLEW_PPB) return -TIMEBASE_MAX_SLEW_PPB;
+	return (int32_t)ppb;
+}
+
+static void timebase_publish(const timebase_slot_t *slot)
+{
+	uint32_t sequence = timebase_sequence;
+
+	timebase_slot[(sequence + 1) & 1] = *slot;
+	TIMEBASE_STORE(timebase_sequence, sequence + 1);
+}
+
+// Sample of the reference given to the discipline, called with the interrupts masked : the state and the slot are
+// updated together whichever interrupt or main loop gives the reference
+static int64_t timebase_discipline_update(uint64_t reference_us)
+{
+	timebase_discipline_t *discipline = &timebase_discipline_state;
+	timebase_slot_t slot = timebase_slot[timebase_sequence & 1];
+	int64_t offset_us;
+	int64_t phase_ppb = 0;
+
+	timebase_slot_advance(&slot, TIMEBASE_COUNTER());
+	offset_us = (int64_t)(reference_us - (slot.base_us + slot.epoch_us));
+
+	if(!discipline->synchronized || offset_us > TIMEBASE_STEP_THRESHOLD_US || offset_us < -TIMEBASE_STEP_THRESHOLD_US)
+	{
+		// Far from the reference : time is stepped, drift estimation goes on from the next sample
+		slot.epoch_us += offset_us;
+		discipline->synchronized = 1;
+	}
+	else if(reference_us > discipline->reference_us)
+	{
+		// Previous offset has been slewed during the interval : what is left comes from the drift, half of it is corrected
+		int64_t interval_us = (int64_t)(reference_us - discipline->reference_us);
+		int64_t error_ppb = offset_us * 1000000000LL / interval_us;
+
+		discipline->drift_ppb = timebase_clamp_ppb(discipline->drift_ppb + error_ppb / 2);
+		phase_ppb = error_ppb;
+	}
+	discipline->reference_us = reference_us;
+
+	// Offset is slewed out during the next interval, supposed as long as this one
+	slot.rate = (int32_t)(((int64_t)timebase_clamp_ppb(discipline->drift_ppb + phase_ppb) << TIMEBASE_RATE_SHIFT) / 1000000000LL);
+	timebase_publish(&slot);
+
+	return offset_us;
+}
+
+/*
+   +========================================+
+				Functions definition
+   +========================================+
+*/
+status_code_t timebase_init(uint32_t cpu_hz)
+{
+	timebase_slot_t slot = {.base_us = 0, .epoch_us = 0, .rate = 0, .rate_remainder = 0};
+
+	// Counter is converted in whole cycles per microsecond, the conversions would divide by 0
+	if(cpu_hz < 1000000UL) return ERR_INVALID_ARG;
+
+	#if !defined(TEST)
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = TIMEBASE_DWT_LAR_KEY;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	#endif
+
+	cycles_per_us = cpu_hz / 1000000UL;
+	slot.base_counter = TIMEBASE_COUNTER();
+	timebase_discipline_state.synchronized = 0;
+	timebase_discipline_state.drift_ppb = 0;
+	timebase_discipline_state.pps_rejected = 0;
+	timebase_publish(&slot);
+
+	return STATUS_OK;
+}
+
+void timebase_tick(void)
+{
+	uint32_t flags = TIMEBASE_LOCK();
+	timebase_slot_t slot = timebase_slot[timebase_sequence & 1];
+
+	timebase_slot_advance(&slot, TIMEBASE_COUNTER());
+	timebase_publish(&slot);
+	TIMEBASE_UNLOCK(flags);
+}
+
+uint64_t timebase_monotonic_us(void)
+{
+	timebase_slot_t slot;
+
+	timebase_read(&slot);
+	return timebase_slot_us(&slot, TIMEBASE_COUNTER());
+}
+
+void timebase_set_epoch_us(uint64_t unix_us)
+{
+	uint32_t flags = TIMEBASE_LOCK();
+	timebase_slot_t slot = timebase_slot[timebase_sequence & 1];
+
+	slot.epoch_us = unix_us - timebase_slot_us(&slot, TIMEBASE_COUNTER());
+	timebase_publish(&slot);
+	TIMEBASE_UNLOCK(flags);
+}
+
+uint64_t timebase_unix_us(void)
+{
+	timebase_slot_t slot;
+
+	timebase_read(&slot);
+	return timebase_slot_us(&slot, TIMEBASE_COUNTER()) + slot.epoch_us;
+}
+
+int64_t timebase_discipline(uint64_t reference_us)
+{
+	uint32_t flags = TIMEBASE_LOCK();
+	int64_t offset_us = timebase_discipline_update(reference_us);
+
+	TIMEBASE_UNLOCK(flags);
+	return offset_us;
+}
+
+int64_t timebase_discipline_pps(void)
+{
+	timebase_discipline_t *discipline = &timebase_discipline_state;
+	uint32_t flags = TIMEBASE_LOCK();
+	timebase_slot_t slot = timebase_slot[timebase_sequence & 1];
+	uint64_t local_us;
+	uint64_t reference_us;
+	int64_t offset_us;
+
+	timebase_slot_advance(&slot, TIMEBASE_COUNTER());
+	local_us = slot.base_us + slot.epoch_us;
+	// Edge comes on a second of the reference, the closest one of the current time : a missed edge doesn't shift the time
+	reference_us = (local_us + 500000ULL) / 1000000ULL * 1000000ULL;
+	offset_us = (int64_t)(reference_us - local_us);
+
+	// Once synchronized, an edge in the second of the previous one or far from a second is a glitch of the line,
+	// unless edges keep coming that way : the reference has then really moved
+	if(discipline->synchronized
+	&& (reference_us <= discipline->reference_us || offset_us > TIMEBASE_STEP_THRESHOLD_US || offset_us < -TIMEBASE_STEP_THRESHOLD_US)
+	&& ++discipline->pps_rejected < TIMEBASE_PPS_MAX_REJECTED)
+	{
+		TIMEBASE_UNLOCK(flags);
+		return TIMEBASE_PPS_REJECTED;
+	}
+	discipline->pps_rejected = 0;
+	offset_us = timebase_discipline_update(reference_us);
+	TIMEBASE_UNLOCK(flags);
+
+	return offset_us;
+}
+
+int32_t timebase_drift_ppb(void)
+{
+	return timebase_discipline_state.drift_ppb;
+}
+
+/**
+ * \brief Handler for System Tick interrupt.
+ *
+ * Extends the cycle counter of the time base.
+ */
+void SysTick_Handler(void)
+{
+	timebase_tick();
+}
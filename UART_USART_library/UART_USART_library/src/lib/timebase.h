@@ -0,0 +1,146 @@
+/************************************************************************
+Title:    Time Base Library
+Author:   Julien Delvaux
+Software: Atmel Studio 7
+Hardware: SAME70Q21
+License:  GNU General Public License 3
+Usage:    see Doxygen manual
+
+LICENSE:
+	Copyright (C) 2018 Julien Delvaux
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+
+************************************************************************/
+
+/**
+ *  @defgroup Time Base Library
+ *  @code #include <timebase.h> @endcode
+ *
+ *  @brief Monotonic microsecond time base built on the DWT cycle counter.
+ *  The 32 bits cycle counter is extended by timebase_tick, called from the 1 ms SysTick interrupt,
+ *  and an epoch offset gives the Unix time.
+ *  There is one time base for the application. It is read without lock nor masked interrupt
+ *  from the main loop and from any interrupt, 64 bits values are never seen torn.
+ *  timebase_discipline follows a reference clock (RTC) : the drift of the counter is estimated
+ *  and the time is slewed, without going backward, to stay close to the reference.
+ *
+ *  @author Julien Delvaux <delvaux.ju@gmail.com>
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+/*
+   +========================================+
+				Includes
+   +========================================+
+*/
+
+#if defined(TEST)
+#	include <stdint.h>
+#else
+#	include "compiler.h"
+#endif
+
+#include "status_codes.h"
+
+/*
+   +========================================+
+				Defines
+   +========================================+
+*/
+
+// Counter read by the time base : DWT cycle counter, or a variable set by the tests
+#if defined(TEST)
+extern volatile uint32_t timebase_test_counter;
+// Called by the readers between the two reads of the sequence, to preempt them in the tests
+extern void (*timebase_test_read_hook)(void);
+#	define TIMEBASE_COUNTER()	(timebase_test_counter)
+#else
+#	define TIMEBASE_COUNTER()	(DWT->CYCCNT)
+#endif
+
+// Clock discipline : bigger offsets from the reference step the time, smaller ones are slewed
+#define TIMEBASE_STEP_THRESHOLD_US	100000
+// Biggest rate correction applied to the time base (drift and offset), in parts per billion
+#define TIMEBASE_MAX_SLEW_PPB		500000
+// Edges of the 1 Hz reference rejected in a row before the next one is taken as the new reference
+#define TIMEBASE_PPS_MAX_REJECTED	3
+// Given by timebase_discipline_pps for a rejected edge
+#define TIMEBASE_PPS_REJECTED		INT64_MIN
+
+/*
+   +========================================+
+				Functions declaration
+   +========================================+
+*/
+
+/**
+* Start the cycle counter and the time base at 0
+* @param cpu_hz : frequency of the counter, multiple of 1 MHz
+* @return STATUS_OK, ERR_INVALID_ARG below 1 MHz (time base is left as it was)
+*/
+status_code_t timebase_init(uint32_t cpu_hz);
+/**
+* Extend the cycle counter, has to be called at least once per counter lap (14 s at 300 MHz), done by SysTick_Handler
+* @param none
+* @return none
+*/
+void timebase_tick(void);
+/**
+* Give the time since timebase_init
+* @param none
+* @return monotonic time in microseconds
+*/
+uint64_t timebase_monotonic_us(void);
+/**
+* Set the Unix time of now, following calls of timebase_unix_us count from it
+* It can be seeded from a RTC giving milliseconds with unix_ms * 1000
+* @param unix_us : Unix time in microseconds
+* @return none
+*/
+void timebase_set_epoch_us(uint64_t unix_us);
+/**
+* Give the Unix time, monotonic time until timebase_set_epoch_us is called
+* @param none
+* @return Unix time in microseconds
+*/
+uint64_t timebase_unix_us(void);
+/**
+* Give a sample of the reference clock (RTC read, timebase_rtc_discipline for the DS3231M), to be called periodically (every 1 to 60 s)
+* First sample or an offset above TIMEBASE_STEP_THRESHOLD_US steps the time, otherwise the drift estimation
+* is updated and the offset is slewed out during the next interval
+* Samples and edges of timebase_discipline_pps share the drift estimation : only one reference is followed,
+* a single sample can set the time before the edges are given
+* @param reference_us : Unix time of the reference, in microseconds
+* @return offset of the reference from the time base before correction, in microseconds
+*/
+int64_t timebase_discipline(uint64_t reference_us);
+/**
+* Give an edge of a 1 Hz reference (DS3231M SQW on a PIO interrupt), called from its interrupt
+* Each edge is the closest second of the current time, epoch has to be set within half a second
+* Once synchronized, an edge in the same second as the previous one or further than TIMEBASE_STEP_THRESHOLD_US
+* from a second is rejected, up to TIMEBASE_PPS_MAX_REJECTED edges in a row
+* @param none
+* @return offset of the reference from the time base before correction, in microseconds
+*         TIMEBASE_PPS_REJECTED : edge is ignored
+*/
+int64_t timebase_discipline_pps(void);
+/**
+* Give the estimated frequency error of the counter
+* @param none
+* @return drift in parts per billion, positive if the counter is slow
+*/
+int32_t timebase_drift_ppb(void);
+
+#endif /* TIMEBASE_H_ */
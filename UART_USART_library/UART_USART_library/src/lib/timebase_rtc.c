@@ -0,0 +1,52 @@
+/*
+   +========================================+
+				Includes
+   +========================================+
+*/
+#include "timebase_rtc.h"
+
+#if defined(TIMEBASE_RTC_DS3231M)
+
+/*
+   +========================================+
+				Functions
+   +========================================+
+*/
+
+// Unix time of the next change of second of the RTC
+static status_code_t timebase_rtc_sample(ds3231m_t *rtc, uint64_t *p_unix_us)
+{
+	uint64_t start = timebase_monotonic_us();
+	uint8_t second;
+
+	if(DS3231M_get_time(rtc) != TWIHS_SUCCESS) return ERR_IO_ERROR;
+	second = rtc->second;
+	do
+	{
+		if(timebase_monotonic_us() - start > TIMEBASE_RTC_WAIT_US) return ERR_TIMEOUT;
+		if(DS3231M_get_time(rtc) != TWIHS_SUCCESS) return ERR_IO_ERROR;
+	}while(rtc->second == second);
+
+	*p_unix_us = convert_dateTime_to_unixms(rtc) * 1000ULL;
+	return STATUS_OK;
+}
+
+status_code_t timebase_rtc_seed(ds3231m_t *rtc)
+{
+	uint64_t unix_us;
+	status_code_t status = timebase_rtc_sample(rtc, &unix_us);
+
+	if(status == STATUS_OK) timebase_set_epoch_us(unix_us);
+	return status;
+}
+
+status_code_t timebase_rtc_discipline(ds3231m_t *rtc, int64_t *p_offset_us)
+{
+	uint64_t unix_us;
+	status_code_t status = timebase_rtc_sample(rtc, &unix_us);
+
+	if(status == STATUS_OK) *p_offset_us = timebase_discipline(unix_us);
+	return status;
+}
+
+#endif /* TIMEBASE_RTC_DS3231M */
@@ -0,0 +1,90 @@
+/************************************************************************
+Title:    Time Base RTC Reference
+Author:   Julien Delvaux
+Software: Atmel Studio 7
+Hardware: SAME70Q21
+License:  GNU General Public License 3
+Usage:    see Doxygen manual
+
+LICENSE:
+	Copyright (C) 2018 Julien Delvaux
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 3 of the License, or
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+
+************************************************************************/
+
+/**
+ *  @defgroup Time Base RTC Reference
+ *  @code #include <timebase_rtc.h> @endcode
+ *
+ *  @brief Glue between the DS3231M driver of DS3231M_library and the time base.
+ *  The RTC only gives whole seconds : it is read until its second changes, this change is
+ *  the reference given to the time base, within the duration of one read.
+ *  Built when TIMEBASE_RTC_DS3231M is defined : timebase_rtc.c, DS3231M.c/.h of DS3231M_library and
+ *  the ASF TWIHS driver have then to be added to the project, TWIHS0 being initialized as in
+ *  DS3231M_library main.c. Without the driver, the project doesn't build this module.
+ *
+ *  @author Julien Delvaux <delvaux.ju@gmail.com>
+ */
+
+#ifndef TIMEBASE_RTC_H_
+#define TIMEBASE_RTC_H_
+
+/*
+   +========================================+
+				Defines
+   +========================================+
+*/
+
+// Define when the DS3231M driver is part of the project
+//#define TIMEBASE_RTC_DS3231M
+
+// Longest wait of a change of second of the RTC
+#define TIMEBASE_RTC_WAIT_US	1100000
+
+#if defined(TIMEBASE_RTC_DS3231M)
+
+/*
+   +========================================+
+				Includes
+   +========================================+
+*/
+
+#include "timebase.h"
+#include "DS3231M.h"
+#include "twihs.h"
+#include "status_codes.h"
+
+/*
+   +========================================+
+				Functions declaration
+   +========================================+
+*/
+
+/**
+* Set the epoch of the time base from the RTC, blocks until its next second (up to one second)
+* @param rtc : DS3231M initialized by DS3231M_init
+* @return STATUS_OK, ERR_IO_ERROR : RTC not read, ERR_TIMEOUT : RTC second doesn't change
+*/
+status_code_t timebase_rtc_seed(ds3231m_t *rtc);
+/**
+* Give a sample of the RTC to timebase_discipline, blocks until its next second (up to one second)
+* To be called every 1 to 60 s, or once to seed before timebase_discipline_pps when the SQW output is wired
+* @param rtc : DS3231M initialized by DS3231M_init
+* @param p_offset_us : offset of the RTC from the time base before correction, in microseconds
+* @return STATUS_OK, ERR_IO_ERROR : RTC not read, ERR_TIMEOUT : RTC second doesn't change
+*/
+status_code_t timebase_rtc_discipline(ds3231m_t *rtc, int64_t *p_offset_us);
+
+#endif /* TIMEBASE_RTC_DS3231M */
+
+#endif /* TIMEBASE_RTC_H_ */
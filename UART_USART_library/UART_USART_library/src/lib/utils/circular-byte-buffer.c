@@ -1,15 +1,45 @@
 #include "circular-byte-buffer.h"
 
-void circ_bbuf_create_buffer(circ_bbuf_t *buf, const uint32_t size)
+#include <string.h>
+
+// Indexes are published with release semantics and read with acquire semantics,
+// so that data written into the buffer is visible before the index moves.
+#define CBB_LOAD(x)         __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define CBB_STORE(x, v)     __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+uint8_t circ_bbuf_create_buffer(circ_bbuf_t *buf, const uint32_t size)
+{
+    uint32_t capacity = 1;
+    uint8_t *storage;
+
+    while(capacity < size) capacity <<= 1;
+
+    storage = (uint8_t *) malloc(capacity * sizeof(uint8_t));
+    if(storage == NULL) return CBB_ALLOC_ERROR;
+
+    circ_bbuf_init_buffer(buf, storage, capacity);
+
+    return CBB_SUCCESS;
+}
+
+uint8_t circ_bbuf_init_buffer(circ_bbuf_t *buf, uint8_t *storage, const uint32_t size)
 {
-    circ_bbuf_t temp_buffer;
-    temp_buffer.buffer = (uint8_t *) malloc(size * sizeof(uint8_t));
+    circ_bbuf_t temp_buffer = {0};
+
+    // Indexes are masked : any other size would corrupt the ring, the buffer is then left without storage
+    if(size == 0 || (size & (size - 1)) != 0)
+    {
+        *buf = temp_buffer;
+        return CBB_SIZE_ERROR;
+    }
+
+    temp_buffer.buffer = storage;
     temp_buffer.capacity = size;
-    temp_buffer.buffer_status = CBB_BUFFER_EMPTY;
-    temp_buffer.head = 0;
-    temp_buffer.tail = 0;
+    temp_buffer.mask = size - 1;
 
     *buf = temp_buffer;
+
+    return CBB_SUCCESS;
 }
 
 uint32_t circ_bbuf_available_space(circ_bbuf_t *c)
@@ -19,100 +49,137 @@ uint32_t circ_bbuf_available_space(circ_bbuf_t *c)
 
 uint32_t circ_bbuf_available_bytes_to_read(circ_bbuf_t *c)
 {
-    uint32_t bytes_to_read = 0;
-
-    if (c->tail > c->head)
-    {
-        bytes_to_read = c->capacity - c->tail + c->head;
-    }else if (c->head == c->tail && c->buffer_status == CBB_BUFFER_FULL)
-    {
-        bytes_to_read = c->capacity;
-    }else
-    {
-        bytes_to_read = c->head - c->tail;
-    }
-
-    return bytes_to_read;
+    return CBB_LOAD(c->head) - CBB_LOAD(c->tail);
 }
 
 uint8_t circ_bbuf_is_empty(circ_bbuf_t *c)
 {
-    return c->buffer_status == CBB_BUFFER_EMPTY;
+    return CBB_LOAD(c->head) == CBB_LOAD(c->tail);
 }
 
 uint8_t circ_bbuf_is_full(circ_bbuf_t *c)
 {
-    return c->buffer_status == CBB_BUFFER_FULL;
+    return circ_bbuf_available_bytes_to_read(c) == c->capacity;
 }
 
 uint8_t circ_bbuf_push(circ_bbuf_t *c, uint8_t data)
 {
-    uint8_t result = CBB_SUCCESS;
+    uint32_t head = c->head;
 
-    if(!circ_bbuf_is_full(c))
-    {
-        c->buffer[c->head++] = data;
-        c->buffer_status = CBB_BUFFER_FILLING;
-        // Reset the head if reaching the size of the buffer
-        if(c->head >= c->capacity) c->head = 0;
-    }else
-    {
-        result = CBB_BUFFER_FULL;
-    }
+    if(head - CBB_LOAD(c->tail) == c->capacity) return CBB_BUFFER_FULL;
 
-    // If head is joining the tail, all the buffer has been filled.
-    if(c->head == c->tail && c->buffer_status == CBB_BUFFER_FILLING) c->buffer_status = CBB_BUFFER_FULL;
+    c->buffer[head & c->mask] = data;
+    CBB_STORE(c->head, head + 1);
 
-    return result;
+    return CBB_SUCCESS;
 }
 
 uint8_t circ_bbuf_pop(circ_bbuf_t *c, uint8_t *data)
 {
-    uint8_t result = CBB_SUCCESS;
+    uint32_t tail = c->tail;
 
-    if(!circ_bbuf_is_empty(c))
-    {
-        *data = c->buffer[c->tail++];
-        c->buffer_status = CBB_BUFFER_FILLING;
-        // Reset the tail if reaching the size of the buffer
-        if(c->tail >= c->capacity) c->tail = 0;
-    }else
-    {
-        result = CBB_BUFFER_EMPTY;
-    }
-    
-    // If tail is joining the head, all the buffer has been read.
-    if(c->head == c->tail && c->buffer_status == CBB_BUFFER_FILLING) c->buffer_status = CBB_BUFFER_EMPTY;
+    if(CBB_LOAD(c->head) == tail) return CBB_BUFFER_EMPTY;
+
+    *data = c->buffer[tail & c->mask];
+    CBB_STORE(c->tail, tail + 1);
 
-    return result;
+    return CBB_SUCCESS;
 }
 
-uint8_t circ_bbuf_push_bytes(circ_bbuf_t *c, const uint8_t *data, uint32_t len)
+uint32_t circ_bbuf_push_bytes_partial(circ_bbuf_t *c, const uint8_t *data, uint32_t len)
 {
-    uint8_t result = CBB_SUCCESS;
+    uint32_t head = c->head;
+    uint32_t free_space = c->capacity - (head - CBB_LOAD(c->tail));
+    uint32_t to_copy = (len < free_space) ? len : free_space;
+    uint32_t index = head & c->mask;
+    uint32_t first_chunk = c->capacity - index;
 
-    for (uint32_t i = 0; i < len; ++i) {
-        result = circ_bbuf_push(c, *data++);
-        // If buffer is full
-        if(result != CBB_SUCCESS){
-            break;
-        }
-    }
+    if(to_copy == 0) return 0;
 
-    return result;
+    // Copy in at most two segments : up to the end of the buffer, then from its start
+    if(first_chunk > to_copy) first_chunk = to_copy;
+    memcpy(&c->buffer[index], data, first_chunk);
+    memcpy(c->buffer, data + first_chunk, to_copy - first_chunk);
+
+    CBB_STORE(c->head, head + to_copy);
+
+    return to_copy;
 }
 
-uint8_t circ_bbuf_pop_bytes(circ_bbuf_t *c, uint32_t len, uint8_t *data)
+uint32_t circ_bbuf_pop_bytes_partial(circ_bbuf_t *c, uint32_t len, uint8_t *data)
 {
-    uint8_t result = CBB_SUCCESS;
+    uint32_t tail = c->tail;
+    uint32_t available = CBB_LOAD(c->head) - tail;
+    uint32_t to_copy = (len < available) ? len : available;
+    uint32_t index = tail & c->mask;
+    uint32_t first_chunk = c->capacity - index;
 
-    for (uint32_t i = 0; i < len; i++) {
-        result = circ_bbuf_pop(c, data++);
-        // If buffer empty
-        if(result != CBB_SUCCESS){
-            break;
-        }
-    }
+    if(to_copy == 0) return 0;
 
-    return result;
-}
\ No newline at end of file
+    // Copy in at most two segments : up to the end of the buffer, then from its start
+    if(first_chunk > to_copy) first_chunk = to_copy;
+    memcpy(data, &c->buffer[index], first_chunk);
+    memcpy(data + first_chunk, c->buffer, to_copy - first_chunk);
+
+    CBB_STORE(c->tail, tail + to_copy);
+
+    return to_copy;
+}
+
+uint32_t circ_bbuf_advance_head_to(circ_bbuf_t *c, uint32_t index)
+{
+    uint32_t head = c->head;
+    uint32_t free_space = c->capacity - (head - CBB_LOAD(c->tail));
+    uint32_t written = (index - head) & c->mask;
+
+    if(written > free_space) written = free_space;
+    if(written == 0) return 0;
+
+    CBB_STORE(c->head, head + written);
+
+    return written;
+}
+
+void circ_bbuf_reset_to(circ_bbuf_t *c, uint32_t index)
+{
+    // Indexes keep running forward
+    uint32_t head = c->head + ((index - c->head) & c->mask);
+
+    CBB_STORE(c->tail, head);
+    CBB_STORE(c->head, head);
+}
+
+uint32_t circ_bbuf_peek_contiguous(circ_bbuf_t *c, uint8_t **data)
+{
+    uint32_t tail = c->tail;
+    uint32_t available = CBB_LOAD(c->head) - tail;
+    uint32_t index = tail & c->mask;
+    uint32_t contiguous = c->capacity - index;
+
+    *data = &c->buffer[index];
+
+    return (available < contiguous) ? available : contiguous;
+}
+
+uint32_t circ_bbuf_skip(circ_bbuf_t *c, uint32_t len)
+{
+    uint32_t tail = c->tail;
+    uint32_t available = CBB_LOAD(c->head) - tail;
+
+    if(len > available) len = available;
+
+    CBB_STORE(c->tail, tail + len);
+
+    return len;
+}
+
+
+uint8_t circ_bbuf_push_bytes(circ_bbuf_t *c, const uint8_t *data, uint32_t len)
+{
+    return (circ_bbuf_push_bytes_partial(c, data, len) == len) ? CBB_SUCCESS : CBB_BUFFER_FULL;
+}
+
+uint8_t circ_bbuf_pop_bytes(circ_bbuf_t *c, uint32_t len, uint8_t *data)
+{
+    return (circ_bbuf_pop_bytes_partial(c, len, data) == len) ? CBB_SUCCESS : CBB_BUFFER_EMPTY;
+}
@@ -15,9 +15,12 @@ Based on Siddharth Chandrasekaran library : https://github.com/EmbedJournal/c-ut
 
 This implementation provides in addition to original library:
  - 3 more functions to check buffer status and availability
- - Push/Retrieve multiples bytes with one function call
+ - Push/Retrieve multiples bytes with one function call (bulk copy, at most two segments)
  - Full buffer size can be used : every byte in buffer is used
  - Embedded micro-controller targeted
+ - Lock-free single-producer/single-consumer (ISR/main loop) : capacity is a power of two
+ - Storage filled by an external producer (DMA) with circ_bbuf_advance_head_to, restarted after an overrun with circ_bbuf_reset_to
+ - In place read of contiguous bytes (DMA) with circ_bbuf_peek_contiguous/circ_bbuf_skip
  
 */
 
@@ -27,34 +30,52 @@ This implementation provides in addition to original library:
 #include <stdint.h>
 #include <stdlib.h>
 
+// Buffer is shared between one producer and one consumer (ISR/main loop)
+// Head is only written by the producer and tail only by the consumer : no critical section is needed.
+// Indexes are free-running and capacity has to be a power of two.
 typedef struct {
     uint8_t * buffer;
-    uint32_t head;
-    uint32_t tail;
+    volatile uint32_t head;
+    volatile uint32_t tail;
     uint32_t capacity;
-    uint8_t buffer_status;
+    uint32_t mask;
 } circ_bbuf_t;
 
-enum CBB_RESULT{CBB_SUCCESS, CBB_BUFFER_EMPTY, CBB_BUFFER_FULL, CBB_BUFFER_FILLING};
+enum CBB_RESULT{CBB_SUCCESS, CBB_BUFFER_EMPTY, CBB_BUFFER_FULL, CBB_BUFFER_FILLING, CBB_ALLOC_ERROR, CBB_SIZE_ERROR};
 
 // This has to be used outside of micro controllers
 #define CIRC_BBUF_DEF(x,y)                 \
+    _Static_assert(((y) & ((y) - 1)) == 0, \
+        "circ_bbuf capacity must be a power of two"); \
     uint8_t x##_data_space[y];             \
     circ_bbuf_t x = {                      \
         .buffer = x##_data_space,          \
         .head = 0,                         \
         .tail = 0,                         \
         .capacity = y,                     \
-        .buffer_status = CBB_BUFFER_EMPTY  \
+        .mask = (y) - 1                    \
     }
 
 /**
 * Create the circ_bbuf_t buffer inside micro controller environment
+* Size is rounded up to the next power of two
 * @param buf
 * @param size
-* @return none
+* @return CBB_SUCCESS
+*         CBB_ALLOC_ERROR
 */
-void circ_bbuf_create_buffer(circ_bbuf_t *buf, const uint32_t size);
+uint8_t circ_bbuf_create_buffer(circ_bbuf_t *buf, const uint32_t size);
+
+/**
+* Initialize the circ_bbuf_t buffer on a storage provided by the caller (no allocation)
+* Size has to be a power of two
+* @param buf
+* @param storage
+* @param size
+* @return CBB_SUCCESS
+*         CBB_SIZE_ERROR : size isn't a power of two, the buffer has no storage
+*/
+uint8_t circ_bbuf_init_buffer(circ_bbuf_t *buf, uint8_t *storage, const uint32_t size);
 
 /**
 * Gives how much free space is available in the buffer
@@ -107,6 +128,7 @@ uint8_t circ_bbuf_push(circ_bbuf_t *c, uint8_t data);
 
 /**
  * Insert multiples bytes into buffer
+ * Bytes are copied as long as there is space, remaining ones are dropped
  * @param c
  * @param data
  * @param len
@@ -117,12 +139,67 @@ uint8_t circ_bbuf_push_bytes(circ_bbuf_t *c, const uint8_t *data, uint32_t len);
 
 /**
  * Retrieve multiples bytes from buffer
+ * Bytes are copied as long as there is data, remaining ones are untouched
  * @param c
  * @param data
  * @param len
  * @return CBB_SUCCESS
- *         CBB_BUFFER_FULL
+ *         CBB_BUFFER_EMPTY
  */
 uint8_t circ_bbuf_pop_bytes(circ_bbuf_t *c, uint32_t len, uint8_t *data);
 
+/**
+ * Insert up to len bytes into buffer
+ * @param c
+ * @param data
+ * @param len
+ * @return Number of bytes inserted
+ */
+uint32_t circ_bbuf_push_bytes_partial(circ_bbuf_t *c, const uint8_t *data, uint32_t len);
+
+/**
+ * Retrieve up to len bytes from buffer
+ * @param c
+ * @param len
+ * @param data
+ * @return Number of bytes retrieved
+ */
+uint32_t circ_bbuf_pop_bytes_partial(circ_bbuf_t *c, uint32_t len, uint8_t *data);
+
+/**
+ * Publish bytes already written into the storage by an external producer (DMA)
+ * Head is moved up to index (0 to capacity-1), limited to the free space.
+ * It has to be called at least once per buffer lap of the producer, more bytes than the free space
+ * mean that unread bytes have been overwritten : the caller has to use circ_bbuf_reset_to instead.
+ * @param c
+ * @param index
+ * @return Number of bytes published
+ */
+uint32_t circ_bbuf_advance_head_to(circ_bbuf_t *c, uint32_t index);
+
+/**
+ * Drop the bytes and restart the empty buffer at index (0 to capacity-1), position of an external producer (DMA)
+ * Head and tail are both written : neither the producer nor the consumer may use the buffer meanwhile.
+ * @param c
+ * @param index
+ * @return none
+ */
+void circ_bbuf_reset_to(circ_bbuf_t *c, uint32_t index);
+
+/**
+ * Give the bytes that can be read in place, up to the end of the storage
+ * @param c
+ * @param data : set to the first byte to read
+ * @return Number of contiguous bytes
+ */
+uint32_t circ_bbuf_peek_contiguous(circ_bbuf_t *c, uint8_t **data);
+
+/**
+ * Drop bytes from buffer once they have been read in place
+ * @param c
+ * @param len
+ * @return Number of bytes dropped
+ */
+uint32_t circ_bbuf_skip(circ_bbuf_t *c, uint32_t len);
+
 #endif /* __CIRCULAR_BYTE_BUFFER_H_ */
@@ -0,0 +1,222 @@
+#include "frame-queue.h"
+
+// Indexes are published with release semantics and read with acquire semantics,
+// so that bytes and descriptors are visible before the index moves.
+#define FQ_LOAD(x)          __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define FQ_STORE(x, v)      __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+static void fq_reset_pending(frame_queue_t *q)
+{
+    q->pending.timestamp = 0;
+    q->pending.errors = 0;
+    q->dropping = 0;
+}
+
+// Bytes already written into the storage keep their place for the ones coming after them : an empty descriptor
+// ending after them is published so that the reader skips them. Without descriptor left, they are skipped with the next frame.
+static void fq_drop_pending(frame_queue_t *q)
+{
+    uint32_t head = q->head;
+
+    q->skip = (q->producer - q->write) & q->bytes->mask;
+    q->pending.start = q->write;
+    if(q->write != q->bytes->head && head - FQ_LOAD(q->tail) != q->capacity)
+    {
+        q->desc[head & q->mask].start = q->write;
+        q->desc[head & q->mask].length = 0;
+        FQ_STORE(q->bytes->head, q->write);
+        FQ_STORE(q->head, head + 1);
+    }
+    fq_reset_pending(q);
+}
+
+uint8_t fq_create_queue(frame_queue_t *q, circ_bbuf_t *bytes, const uint32_t size, uint8_t port)
+{
+    uint32_t capacity = 1;
+    frame_desc_t *storage;
+
+    while(capacity < size) capacity <<= 1;
+
+    storage = (frame_desc_t *) malloc(capacity * sizeof(frame_desc_t));
+    if(storage == NULL) return FQ_ALLOC_ERROR;
+
+    fq_init_queue(q, bytes, storage, capacity, port);
+
+    return FQ_SUCCESS;
+}
+
+void fq_init_queue(frame_queue_t *q, circ_bbuf_t *bytes, frame_desc_t *storage, const uint32_t size, uint8_t port)
+{
+    q->bytes = bytes;
+    q->desc = storage;
+    q->capacity = size;
+    q->mask = size - 1;
+    q->head = 0;
+    q->tail = 0;
+    q->pending.port = port;
+    q->pending.start = bytes->head;
+    q->write = bytes->head;
+    q->producer = bytes->head & bytes->mask;
+    q->skip = 0;
+    fq_reset_pending(q);
+}
+
+uint32_t fq_available_frames(frame_queue_t *q)
+{
+    return FQ_LOAD(q->head) - FQ_LOAD(q->tail);
+}
+
+uint32_t fq_pending_length(frame_queue_t *q)
+{
+    return q->dropping ? 0 : q->write - q->pending.start;
+}
+
+void fq_set_timestamp(frame_queue_t *q, uint64_t timestamp)
+{
+    q->pending.timestamp = timestamp;
+}
+
+void fq_add_errors(frame_queue_t *q, uint8_t errors)
+{
+    q->pending.errors |= errors;
+}
+
+uint8_t fq_push(frame_queue_t *q, uint8_t data)
+{
+    circ_bbuf_t *bytes = q->bytes;
+
+    if(q->dropping) return FQ_FRAME_DROPPED;
+
+    if(q->write - FQ_LOAD(bytes->tail) == bytes->capacity)
+    {
+        // Frame doesn't fit : bytes already stored are forgotten
+        q->dropping = 1;
+        q->write = q->pending.start;
+        q->producer = q->write & bytes->mask;
+        return FQ_BYTES_FULL;
+    }
+
+    bytes->buffer[q->write & bytes->mask] = data;
+    q->write++;
+    q->producer = q->write & bytes->mask;
+
+    return FQ_SUCCESS;
+}
+
+uint32_t fq_advance_to(frame_queue_t *q, uint32_t index)
+{
+    circ_bbuf_t *bytes = q->bytes;
+    uint32_t free_space = bytes->capacity - (q->write - FQ_LOAD(bytes->tail));
+    uint32_t written = (index - q->write) & bytes->mask;
+    uint32_t skipped;
+
+    q->producer = index;
+    if(written > free_space)
+    {
+        // Producer has written over unread bytes : they are dropped by fq_reset_to
+        q->dropping = 1;
+        return 0;
+    }
+
+    // End of a dropped frame comes first
+    skipped = (written < q->skip) ? written : q->skip;
+    q->write += skipped;
+    q->skip -= skipped;
+    q->pending.start += skipped;
+    q->write += written - skipped;
+
+    return written - skipped;
+}
+
+void fq_reset_to(frame_queue_t *q, uint32_t index, uint8_t in_frame)
+{
+    // Descriptors then bytes : every frame queued is dropped
+    FQ_STORE(q->tail, q->head);
+    circ_bbuf_reset_to(q->bytes, index);
+    q->write = q->bytes->head;
+    q->pending.start = q->write;
+    q->producer = index;
+    q->skip = 0;
+    fq_reset_pending(q);
+    q->dropping = in_frame;
+}
+
+uint8_t fq_end(frame_queue_t *q)
+{
+    uint32_t head = q->head;
+    frame_desc_t *frame;
+
+    if(q->dropping)
+    {
+        fq_drop_pending(q);
+        return FQ_FRAME_DROPPED;
+    }
+    if(q->write == q->pending.start) return FQ_EMPTY;
+    if(head - FQ_LOAD(q->tail) == q->capacity)
+    {
+        fq_drop_pending(q);
+        return FQ_DESC_FULL;
+    }
+
+    frame = &q->desc[head & q->mask];
+    *frame = q->pending;
+    frame->length = q->write - frame->start;
+
+    // Bytes then descriptor : a descriptor seen by the reader always has its bytes
+    FQ_STORE(q->bytes->head, q->write);
+    FQ_STORE(q->head, head + 1);
+    q->pending.start = q->write;
+    fq_reset_pending(q);
+
+    return FQ_SUCCESS;
+}
+
+uint8_t fq_peek(frame_queue_t *q, frame_desc_t *frame)
+{
+    uint32_t tail = q->tail;
+
+    // Dropped frames are released as soon as they are seen
+    while(FQ_LOAD(q->head) != tail)
+    {
+        *frame = q->desc[tail & q->mask];
+        if(frame->length != 0) return FQ_SUCCESS;
+        fq_release(q);
+        tail++;
+    }
+
+    return FQ_EMPTY;
+}
+
+void fq_frame_data(frame_queue_t *q, const frame_desc_t *frame, uint8_t *data[2], uint32_t length[2])
+{
+    uint32_t index = frame->start & q->bytes->mask;
+    uint32_t contiguous = q->bytes->capacity - index;
+
+    data[0] = &q->bytes->buffer[index];
+    if(frame->length > contiguous)
+    {
+        length[0] = contiguous;
+        data[1] = q->bytes->buffer;
+        length[1] = frame->length - contiguous;
+    }else
+    {
+        length[0] = frame->length;
+        data[1] = NULL;
+        length[1] = 0;
+    }
+}
+
+uint8_t fq_release(frame_queue_t *q)
+{
+    uint32_t tail = q->tail;
+    const frame_desc_t *frame;
+
+    if(FQ_LOAD(q->head) == tail) return FQ_EMPTY;
+
+    // Bytes of the frames dropped before this one are released with it
+    frame = &q->desc[tail & q->mask];
+    FQ_STORE(q->bytes->tail, frame->start + frame->length);
+    FQ_STORE(q->tail, tail + 1);
+
+    return FQ_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*
+							 *******************
+******************************* C HEADER FILE *******************************
+**                           *******************                           **
+**                                                                         **
+** project   : c-utils                                                     **
+** filename  : frame-queue                                                 **
+** version   : 1                                                           **
+** date      : January 11, 2019                                            **
+** author    : Julien Delvaux                                              **
+** licence   : MIT                                                         **
+**                                                                         **
+*****************************************************************************
+
+Queue of received frames : bytes are kept in a circular-byte-buffer and every frame
+is described by a descriptor (start, length, timestamp, errors, port).
+
+ - Bytes of the frame in progress are only published with its descriptor : the reader
+   never sees bytes without descriptor nor descriptor without bytes
+ - A frame which doesn't fit in the bytes or in the descriptors is dropped whole,
+   fq_peek skips the empty descriptor which releases its bytes
+ - Lock-free single-producer/single-consumer (ISR/main loop), on the free-running indexes of circ_bbuf_t
+ - Storage filled by an external producer (DMA) with fq_advance_to, restarted after an overrun with fq_reset_to
+
+*/
+
+#ifndef FRAME_QUEUE_H_
+#define FRAME_QUEUE_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "circular-byte-buffer.h"
+
+typedef struct {
+	uint64_t timestamp;
+	uint32_t start;			// free-running index of the first byte in the bytes buffer
+	uint32_t length;
+	uint8_t errors;			// reception errors seen during the frame, defined by the user
+	uint8_t port;
+} frame_desc_t;
+
+typedef struct {
+	circ_bbuf_t * bytes;
+	frame_desc_t * desc;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	uint32_t capacity;
+	uint32_t mask;
+	// Producer side
+	frame_desc_t pending;	// frame in progress
+	uint32_t write;			// end of the frame in progress
+	uint32_t producer;		// last index given to fq_advance_to
+	uint32_t skip;			// bytes of a dropped frame still to come from fq_advance_to
+	uint8_t dropping;
+} frame_queue_t;
+
+enum FQ_RESULT{FQ_SUCCESS, FQ_EMPTY, FQ_BYTES_FULL, FQ_DESC_FULL, FQ_FRAME_DROPPED, FQ_ALLOC_ERROR};
+
+/**
+* Create the descriptors of the frame queue inside micro controller environment
+* Size is rounded up to the next power of two
+* @param q
+* @param bytes : bytes buffer of the frames, only filled through the queue
+* @param size : number of descriptors
+* @param port : port given in the descriptors
+* @return FQ_SUCCESS
+*         FQ_ALLOC_ERROR
+*/
+uint8_t fq_create_queue(frame_queue_t *q, circ_bbuf_t *bytes, const uint32_t size, uint8_t port);
+
+/**
+* Initialize the frame queue on descriptors provided by the caller (no allocation)
+* Size has to be a power of two
+* @param q
+* @param bytes : bytes buffer of the frames, only filled through the queue
+* @param storage
+* @param size : number of descriptors
+* @param port : port given in the descriptors
+* @return none
+*/
+void fq_init_queue(frame_queue_t *q, circ_bbuf_t *bytes, frame_desc_t *storage, const uint32_t size, uint8_t port);
+
+/**
+* Gives how many frames have not yet been read from the queue
+* Dropped frames are counted until fq_peek skips them
+* @param q
+* @return Number of frames
+*/
+uint32_t fq_available_frames(frame_queue_t *q);
+
+/**
+* Gives how many bytes are stored in the frame in progress
+* @param q
+* @return Number of bytes, 0 before the first byte of a frame
+*/
+uint32_t fq_pending_length(frame_queue_t *q);
+
+/**
+* Set the timestamp of the frame in progress
+* @param q
+* @param timestamp
+* @return none
+*/
+void fq_set_timestamp(frame_queue_t *q, uint64_t timestamp);
+
+/**
+* Add reception errors to the frame in progress
+* @param q
+* @param errors
+* @return none
+*/
+void fq_add_errors(frame_queue_t *q, uint8_t errors);
+
+/**
+* Add one byte to the frame in progress
+* The frame is dropped when the bytes buffer is full
+* @param q
+* @param data
+* @return FQ_SUCCESS
+*         FQ_BYTES_FULL : frame is dropped with this byte
+*         FQ_FRAME_DROPPED : frame has already been dropped
+*/
+uint8_t fq_push(frame_queue_t *q, uint8_t data);
+
+/**
+* Add the bytes already written into the storage by an external producer (DMA) to the frame in progress
+* More bytes than the free space mean that unread bytes have been overwritten : nothing is added,
+* the frame is dropped and the caller has to use fq_reset_to
+* @param q
+* @param index : position of the producer (0 to capacity-1)
+* @return Number of bytes added
+*/
+uint32_t fq_advance_to(frame_queue_t *q, uint32_t index);
+
+/**
+* Drop every frame and restart the empty queue at index (0 to capacity-1), position of an external producer (DMA)
+* Both sides are written : neither the producer nor the reader may use the queue meanwhile
+* @param q
+* @param index
+* @param in_frame : producer is in the middle of a frame, its bytes are dropped until its end
+* @return none
+*/
+void fq_reset_to(frame_queue_t *q, uint32_t index, uint8_t in_frame);
+
+/**
+* Close the frame in progress : its bytes and its descriptor are published together
+* @param q
+* @return FQ_SUCCESS
+*         FQ_EMPTY : nothing received since the last frame
+*         FQ_DESC_FULL : frame is dropped, no descriptor left
+*         FQ_FRAME_DROPPED : frame has been dropped by fq_push or fq_advance_to
+*/
+uint8_t fq_end(frame_queue_t *q);
+
+/**
+ * Give the oldest frame without removing it from the queue
+ * @param q
+ * @param frame
+ * @return FQ_SUCCESS
+ *         FQ_EMPTY
+ */
+uint8_t fq_peek(frame_queue_t *q, frame_desc_t *frame);
+
+/**
+ * Give the bytes of a frame in place, second part is used when the frame wraps around the storage
+ * @param q
+ * @param frame : frame given by fq_peek
+ * @param data
+ * @param length
+ * @return none
+ */
+void fq_frame_data(frame_queue_t *q, const frame_desc_t *frame, uint8_t *data[2], uint32_t length[2]);
+
+/**
+ * Remove the oldest frame and its bytes from the queue
+ * @param q
+ * @return FQ_SUCCESS
+ *         FQ_EMPTY
+ */
+uint8_t fq_release(frame_queue_t *q);
+
+#endif /* FRAME_QUEUE_H_ */
@@ -31,8 +31,18 @@
 #include <asf.h>
 #include "lib/serial_mdw.h"
 #include "lib/logger.h"
+#include "lib/timebase.h"
+#include "lib/timebase_rtc.h"
 
 #define NUMBER_OF_UART 8
+// Period of the CPU load report
+#define CPU_LOAD_PERIOD_US 10000000ull
+// Clock of the TWIHS bus of the RTC
+#define RTC_TWIHS_CLK 400000
+// Period of the RTC samples given to the time base
+#define RTC_DISCIPLINE_PERIOD_US 60000000ull
+
+static serial_mdw_handle_t uart_handles[NUMBER_OF_UART];
 
 static void configure_uart(void)
 {
@@ -44,14 +54,14 @@ static void configure_uart(void)
 	};
 	
 	/* Initialize UART/USART interfaces. */
-	serial_mdw_init_interface((usart_if)UART0, &serial_option, TIMESTAMP_USED);
-	serial_mdw_init_interface((usart_if)UART1, &serial_option, TIMESTAMP_USED);
-	serial_mdw_init_interface((usart_if)UART2, &serial_option, TIMESTAMP_USED);
-	serial_mdw_init_interface((usart_if)UART3, &serial_option, TIMESTAMP_USED);
-	serial_mdw_init_interface((usart_if)UART4, &serial_option, TIMESTAMP_USED);
-	serial_mdw_init_interface((usart_if)USART0, &serial_option, TIMESTAMP_USED);
-	serial_mdw_init_interface((usart_if)USART1, &serial_option, TIMESTAMP_USED);
-	serial_mdw_init_interface((usart_if)USART2, &serial_option, TIMESTAMP_USED);	
+	serial_mdw_init_interface((usart_if)UART0, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[0]);
+	serial_mdw_init_interface((usart_if)UART1, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[1]);
+	serial_mdw_init_interface((usart_if)UART2, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[2]);
+	serial_mdw_init_interface((usart_if)UART3, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[3]);
+	serial_mdw_init_interface((usart_if)UART4, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[4]);
+	serial_mdw_init_interface((usart_if)USART0, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[5]);
+	serial_mdw_init_interface((usart_if)USART1, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[6]);
+	serial_mdw_init_interface((usart_if)USART2, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &uart_handles[7]);	
 }
 
 int main (void)
@@ -60,6 +70,11 @@ int main (void)
 	sysclk_init();
 	board_init();
 	
+	/* Start the time base of the timestamps, extended by the SysTick */
+	if (timebase_init(sysclk_get_cpu_hz()) != STATUS_OK) {
+		log_error("Error starting the time base");
+	}
+	
 	/* Setup SysTick Timer for 1 msec interrupts */
 	if (SysTick_Config(sysclk_get_cpu_hz() / 1000)) {
 		log_error("Error configuring the systick");
@@ -70,62 +85,120 @@ int main (void)
 	
 	/* Configure UART for debug message output. */
 	logger_init(LOG_DEBUG);
+	// Last warnings and errors are kept in RAM through a reset
+	logger_add_sink(logger_sink_ram_ring, NULL, LOG_WARN);
 		
 	log_info("-- UART_USART Library --\r\n");
 	log_info("-- Developed and made by amof 2018--\r\n");		
+
+#if defined(TIMEBASE_RTC_DS3231M)
+	/* Unix time of the timestamps from the RTC */
+	static ds3231m_t rtc = {.address = DS3231_DEFAULT_ADDRESS};
+	const twihs_options_t twihs_option = {
+		.master_clk = sysclk_get_peripheral_hz(),
+		.speed = RTC_TWIHS_CLK
+	};
+	
+	pmc_enable_periph_clk(ID_TWIHS0);
+	if(twihs_master_init(TWIHS0, &twihs_option) != TWIHS_SUCCESS || DS3231M_init(&rtc) != TWIHS_SUCCESS || timebase_rtc_seed(&rtc) != STATUS_OK){
+		log_error("Error seeding the time base from the RTC\r\n");
+	}
+#endif
 	
 	/* Configure UART-USART */
 	configure_uart();
 		
 	uint8_t buffer[NUMBER_OF_UART][255];
 	volatile uint8_t pointers[NUMBER_OF_UART]={0};
-	const usart_if uart_pointers[NUMBER_OF_UART] ={(usart_if)UART0, (usart_if)UART1, (usart_if)UART2, (usart_if)UART3, (usart_if)UART4, (usart_if)USART0, (usart_if)USART1, (usart_if)USART2} ;
+	uint64_t idle_us = 0;
+	uint32_t frames_too_long = 0;
+	uint64_t load_start = timebase_monotonic_us();
+#if defined(TIMEBASE_RTC_DS3231M)
+	uint64_t rtc_start = load_start;
+#endif
 	
 	while (1)
 	{
 		// 1. Transmission test
 		// All TX are functional
- 		/*serial_mdw_send_bytes((usart_if)UART0, (const uint8_t*)"UART0", 5);
- 		serial_mdw_send_bytes((usart_if)UART1, (const uint8_t*)"UART1", 5);
- 		serial_mdw_send_bytes((usart_if)UART2, (const uint8_t*)"UART2", 5);
- 		serial_mdw_send_bytes((usart_if)UART3, (const uint8_t*)"UART3", 5);
- 		serial_mdw_send_bytes((usart_if)UART4, (const uint8_t*)"UART4", 5);
- 		serial_mdw_send_bytes((usart_if)USART0, (const uint8_t*)"USART0", 6);
- 		serial_mdw_send_bytes((usart_if)USART1, (const uint8_t*)"USART1", 6);
- 		serial_mdw_send_bytes((usart_if)USART2, (const uint8_t*)"USART2", 6);
+ 		/*serial_mdw_send_bytes(uart_handles[0], (const uint8_t*)"UART0", 5);
+ 		serial_mdw_send_bytes(uart_handles[1], (const uint8_t*)"UART1", 5);
+ 		serial_mdw_send_bytes(uart_handles[2], (const uint8_t*)"UART2", 5);
+ 		serial_mdw_send_bytes(uart_handles[3], (const uint8_t*)"UART3", 5);
+ 		serial_mdw_send_bytes(uart_handles[4], (const uint8_t*)"UART4", 5);
+ 		serial_mdw_send_bytes(uart_handles[5], (const uint8_t*)"USART0", 6);
+ 		serial_mdw_send_bytes(uart_handles[6], (const uint8_t*)"USART1", 6);
+ 		serial_mdw_send_bytes(uart_handles[7], (const uint8_t*)"USART2", 6);
  		delay_ms(50);*/
 		
 		// 2. Reception test
 		// All UART and USART are OK
 		/*for (uint8_t i = 0; i<number_of_uart; i++)
 		{
-			if(serial_mdw_available_bytes(uart_pointers[i])>0){
+			if(serial_mdw_available_bytes(uart_handles[i])>0){
 				uint8_t received = 0;
 				uint8_t point_temp = pointers[i];
 
-				serial_mdw_read_byte(uart_pointers[i], &received);
+				serial_mdw_read_byte(uart_handles[i], &received);
 				buffer[i][point_temp] = received;
 				pointers[i] = point_temp + 1;
 				if(pointers[i]==5){
-					log_buffer("Received:", "\r\n",buffer[i], 5);
-					serial_mdw_send_bytes(uart_pointers[i], buffer[i], 5);
+					log_dump_info("Received:", buffer[i], 5, LOGGER_DUMP_DECIMAL);
+					serial_mdw_send_bytes(uart_handles[i], buffer[i], 5);
 					pointers[i] = 0;
 				}
 			}
 		}*/
 		
 		// 3. Reception test with timestamp
- 		for (uint8_t i = 0; i<NUMBER_OF_UART; i++)
- 		{
-	 		if(serial_mdw_timestamp_available(uart_pointers[i])>0){
-				
-		 		serial_mdw_data_timestamp_t data_timestamp;
-		 		serial_mdw_timestamp_read(uart_pointers[i], &data_timestamp);
-		 		log_debug("(%llu):%s\r\n", data_timestamp.timestamp, log_buffer(data_timestamp.data, data_timestamp.length));
-		 		serial_mdw_send_bytes(uart_pointers[i], data_timestamp.data, data_timestamp.length);
-	 		}
- 		}
- 		
+		// Core sleeps until an interface has received a frame, ready interfaces are then served in turn, one frame each
+		uint64_t sleep_start = timebase_monotonic_us();
+		serial_mdw_wait_rx_events();
+		uint64_t now = timebase_monotonic_us();
+		idle_us += now - sleep_start;
+		
+		serial_mdw_handle_t ready;
+		while(serial_mdw_next_ready(&ready)){
+			uint8_t frame[SERIAL_MDW_BUFFER_SIZE];
+			uint32_t length;
+			uint64_t timestamp;
+			status_code_t status = serial_mdw_frame_read(ready, frame, sizeof(frame), &length, &timestamp);
+			if(status == ERR_NO_MEMORY){
+				// Frame longer than the buffer (RX buffer configured bigger) is kept by the read : it is dropped
+				// in place, otherwise the interface would stay ready with it forever
+				serial_mdw_frame_t dropped;
+				if(serial_mdw_frame_peek(ready, &dropped) == STATUS_OK){
+					serial_mdw_frame_commit(ready, &dropped);
+				}
+				frames_too_long++;
+				log_warn("Frame of %lu bytes dropped, %lu so far\r\n", (unsigned long)length, (unsigned long)frames_too_long);
+			}else if(status == STATUS_OK && length != 0){
+				log_debug("(%llu): %lu bytes\r\n", timestamp, (unsigned long)length);
+				log_dump_debug(NULL, frame, length, LOGGER_DUMP_DECIMAL);
+				serial_mdw_send_bytes(ready, frame, length);
+			}
+		}
+		
+		// Share of the time spent out of the wait (interrupts served while waiting count as idle), reported after each period
+		if(now - load_start >= CPU_LOAD_PERIOD_US){
+			log_info("CPU load: %lu per mille\r\n", (unsigned long)(1000 - (idle_us * 1000) / (now - load_start)));
+			load_start = now;
+			idle_us = 0;
+		}
+		
+#if defined(TIMEBASE_RTC_DS3231M)
+		// Drift of the time base is corrected from the RTC, the sample waits for its next second
+		if(now - rtc_start >= RTC_DISCIPLINE_PERIOD_US){
+			int64_t offset_us;
+			if(timebase_rtc_discipline(&rtc, &offset_us) == STATUS_OK){
+				log_debug("RTC offset: %ld us, drift: %ld ppb\r\n", (long)offset_us, (long)timebase_drift_ppb());
+			}
+			rtc_start = timebase_monotonic_us();
+		}
+#endif
+		
+		// Deferred logs are formatted once the frames are served
+		logger_process(LOGGER_DEFERRED_RECORDS);
 	}
 }
 
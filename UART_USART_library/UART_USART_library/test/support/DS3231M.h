@@ -0,0 +1,27 @@
+/*
+ * DS3231M driver of DS3231M_library as seen by timebase_rtc, mocked by its test.
+ * The driver isn't part of this project, only the declarations used by the glue are kept.
+ */
+
+#ifndef DS3231M_H_
+#define DS3231M_H_
+
+#include <stdint.h>
+
+#define DS3231_DEFAULT_ADDRESS 0x68
+
+typedef struct ds3231m_t {
+	uint8_t address;		// Address of the DS3231M
+	uint16_t year; 			// Year
+	uint8_t month; 			// Month
+	uint8_t day_of_week; 	// Day Of The Week
+	uint8_t date; 			// Date of day in the month
+	uint8_t hour; 			// Hour
+	uint8_t minute; 		// Minute 
+	uint8_t second; 		// Second
+} ds3231m_t;
+
+uint32_t DS3231M_get_time(ds3231m_t *ds3231m);
+uint64_t convert_dateTime_to_unixms(ds3231m_t *ds3231m);
+
+#endif /* DS3231M_H_ */
@@ -0,0 +1,26 @@
+/*
+ * Cycle counter used by the host benchmarks.
+ * Uses the time stamp counter on x86 hosts, falls back to clock() otherwise
+ * (in that case, values are CPU clock ticks and not cycles).
+ */
+
+#ifndef BENCH_CYCLES_H_
+#define BENCH_CYCLES_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+static inline uint64_t bench_cycles(void)
+{
+    return __rdtsc();
+}
+#else
+static inline uint64_t bench_cycles(void)
+{
+    return (uint64_t)clock();
+}
+#endif
+
+#endif /* BENCH_CYCLES_H_ */
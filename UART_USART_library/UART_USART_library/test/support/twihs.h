@@ -0,0 +1,12 @@
+/*
+ * Return codes of the ASF TWIHS driver used by timebase_rtc, the driver isn't part of this project.
+ */
+
+#ifndef TWIHS_H_INCLUDED
+#define TWIHS_H_INCLUDED
+
+#define TWIHS_SUCCESS              0
+#define TWIHS_NO_CHIP_FOUND        3
+#define TWIHS_RECEIVE_NACK         5
+
+#endif /* TWIHS_H_INCLUDED */
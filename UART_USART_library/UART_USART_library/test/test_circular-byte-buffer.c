@@ -0,0 +1,184 @@
+#define UNITY_LONG_WIDTH 64
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "bench_cycles.h"
+#include "circular-byte-buffer.h"
+
+#define BENCH_BUFFER_SIZE   256
+#define BENCH_FRAME_SIZE    64
+#define BENCH_ITERATIONS    100000
+
+static circ_bbuf_t buffer;
+
+void setUp(void)
+{
+    circ_bbuf_create_buffer(&buffer, 8);
+}
+
+void tearDown(void)
+{
+    free(buffer.buffer);
+}
+
+void test_init_rejects_size_not_power_of_two(void)
+{
+    uint8_t storage[6];
+    circ_bbuf_t rejected;
+
+    TEST_ASSERT_EQUAL_UINT8(CBB_SIZE_ERROR, circ_bbuf_init_buffer(&rejected, storage, sizeof(storage)));
+    TEST_ASSERT_NULL(rejected.buffer);
+    TEST_ASSERT_EQUAL_UINT8(CBB_BUFFER_FULL, circ_bbuf_push(&rejected, 1));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SIZE_ERROR, circ_bbuf_init_buffer(&rejected, storage, 0));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_init_buffer(&rejected, storage, 4));
+}
+
+void test_push_bytes_wraps_around(void)
+{
+    const uint8_t data_in[] = {1, 2, 3, 4, 5, 6};
+    uint8_t data_out[6] = {0};
+
+    // Move head and tail to the middle of the buffer
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_push_bytes(&buffer, data_in, 5));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_pop_bytes(&buffer, 5, data_out));
+
+    // This push is split in two segments
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_push_bytes(&buffer, data_in, 6));
+    TEST_ASSERT_EQUAL_UINT32(6, circ_bbuf_available_bytes_to_read(&buffer));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_pop_bytes(&buffer, 6, data_out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data_in, data_out, 6);
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&buffer));
+}
+
+void test_push_bytes_fills_buffer(void)
+{
+    const uint8_t data_in[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    uint8_t data_out[10] = {0};
+
+    TEST_ASSERT_EQUAL_UINT8(CBB_BUFFER_FULL, circ_bbuf_push_bytes(&buffer, data_in, 10));
+    TEST_ASSERT_TRUE(circ_bbuf_is_full(&buffer));
+    TEST_ASSERT_EQUAL_UINT32(8, circ_bbuf_available_bytes_to_read(&buffer));
+
+    TEST_ASSERT_EQUAL_UINT8(CBB_BUFFER_EMPTY, circ_bbuf_pop_bytes(&buffer, 10, data_out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data_in, data_out, 8);
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&buffer));
+}
+
+void test_partial_returns_moved_bytes(void)
+{
+    const uint8_t data_in[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    uint8_t data_out[10] = {0};
+
+    TEST_ASSERT_EQUAL_UINT32(6, circ_bbuf_push_bytes_partial(&buffer, data_in, 6));
+    TEST_ASSERT_EQUAL_UINT32(2, circ_bbuf_push_bytes_partial(&buffer, &data_in[6], 4));
+    TEST_ASSERT_EQUAL_UINT32(0, circ_bbuf_push_bytes_partial(&buffer, data_in, 1));
+
+    TEST_ASSERT_EQUAL_UINT32(3, circ_bbuf_pop_bytes_partial(&buffer, 3, data_out));
+    TEST_ASSERT_EQUAL_UINT32(5, circ_bbuf_pop_bytes_partial(&buffer, 10, &data_out[3]));
+    TEST_ASSERT_EQUAL_UINT32(0, circ_bbuf_pop_bytes_partial(&buffer, 1, data_out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data_in, data_out, 8);
+}
+
+void test_advance_head_to_publishes_external_writes(void)
+{
+    uint8_t data_out[8] = {0};
+
+    // Bytes written straight into the storage, as done by the DMA
+    memcpy(buffer.buffer, "abcdef", 6);
+    TEST_ASSERT_EQUAL_UINT32(6, circ_bbuf_advance_head_to(&buffer, 6));
+    TEST_ASSERT_EQUAL_UINT32(0, circ_bbuf_advance_head_to(&buffer, 6));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_pop_bytes(&buffer, 6, data_out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("abcdef", data_out, 6);
+
+    // Writer wrapped around the end of the storage
+    memcpy(&buffer.buffer[6], "gh", 2);
+    memcpy(buffer.buffer, "ij", 2);
+    TEST_ASSERT_EQUAL_UINT32(4, circ_bbuf_advance_head_to(&buffer, 2));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_pop_bytes(&buffer, 4, data_out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("ghij", data_out, 4);
+
+    // Never more than the free space
+    TEST_ASSERT_EQUAL_UINT32(4, circ_bbuf_advance_head_to(&buffer, 6));
+    TEST_ASSERT_EQUAL_UINT32(4, circ_bbuf_advance_head_to(&buffer, 2));
+    TEST_ASSERT_TRUE(circ_bbuf_is_full(&buffer));
+    TEST_ASSERT_EQUAL_UINT32(0, circ_bbuf_advance_head_to(&buffer, 5));
+}
+
+void test_reset_to_drops_bytes_and_restarts_at_producer(void)
+{
+    uint8_t data = 0;
+
+    // Producer has gone round the storage while 5 bytes were waiting
+    memcpy(buffer.buffer, "abcde", 5);
+    TEST_ASSERT_EQUAL_UINT32(5, circ_bbuf_advance_head_to(&buffer, 5));
+    circ_bbuf_reset_to(&buffer, 3);
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&buffer));
+    TEST_ASSERT_EQUAL_UINT32(8, circ_bbuf_available_space(&buffer));
+
+    // Following bytes are published from the producer position
+    buffer.buffer[3] = 'x';
+    TEST_ASSERT_EQUAL_UINT32(1, circ_bbuf_advance_head_to(&buffer, 4));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_pop(&buffer, &data));
+    TEST_ASSERT_EQUAL_UINT8('x', data);
+}
+
+void test_peek_contiguous_stops_at_end_of_storage(void)
+{
+    const uint8_t data_in[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t *data;
+
+    TEST_ASSERT_EQUAL_UINT32(0, circ_bbuf_peek_contiguous(&buffer, &data));
+
+    // Move head and tail to the middle of the buffer
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_push_bytes(&buffer, data_in, 6));
+    TEST_ASSERT_EQUAL_UINT32(5, circ_bbuf_skip(&buffer, 5));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_push_bytes(&buffer, data_in, 4));
+
+    // 6, 1, 2 are before the end of the storage, 3, 4 after
+    TEST_ASSERT_EQUAL_UINT32(3, circ_bbuf_peek_contiguous(&buffer, &data));
+    TEST_ASSERT_EQUAL_UINT8(6, data[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, data[2]);
+    TEST_ASSERT_EQUAL_UINT32(3, circ_bbuf_skip(&buffer, 3));
+    TEST_ASSERT_EQUAL_UINT32(2, circ_bbuf_peek_contiguous(&buffer, &data));
+    TEST_ASSERT_EQUAL_UINT8(3, data[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, circ_bbuf_skip(&buffer, 10));
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&buffer));
+}
+
+void test_benchmark_bulk_against_per_byte(void)
+{
+    circ_bbuf_t bench;
+    uint8_t frame[BENCH_FRAME_SIZE];
+    uint8_t output[BENCH_FRAME_SIZE];
+    uint64_t start, per_byte_cycles, bulk_cycles;
+    char message[128];
+
+    for(uint32_t i = 0; i < BENCH_FRAME_SIZE; i++) frame[i] = (uint8_t)i;
+    circ_bbuf_create_buffer(&bench, BENCH_BUFFER_SIZE);
+
+    // Previous implementation : one push/pop per byte
+    start = bench_cycles();
+    for(uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+        for(uint32_t j = 0; j < BENCH_FRAME_SIZE; j++) circ_bbuf_push(&bench, frame[j]);
+        for(uint32_t j = 0; j < BENCH_FRAME_SIZE; j++) circ_bbuf_pop(&bench, &output[j]);
+    }
+    per_byte_cycles = bench_cycles() - start;
+
+    // Bulk implementation
+    start = bench_cycles();
+    for(uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+        circ_bbuf_push_bytes(&bench, frame, BENCH_FRAME_SIZE);
+        circ_bbuf_pop_bytes(&bench, BENCH_FRAME_SIZE, output);
+    }
+    bulk_cycles = bench_cycles() - start;
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, output, BENCH_FRAME_SIZE);
+
+    snprintf(message, sizeof(message), "per-byte: %.3f bytes/cycle, bulk: %.3f bytes/cycle",
+        (double)BENCH_ITERATIONS * BENCH_FRAME_SIZE / (double)per_byte_cycles,
+        (double)BENCH_ITERATIONS * BENCH_FRAME_SIZE / (double)bulk_cycles);
+    TEST_MESSAGE(message);
+
+    free(bench.buffer);
+}
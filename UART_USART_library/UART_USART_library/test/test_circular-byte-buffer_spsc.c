@@ -0,0 +1,103 @@
+#define UNITY_LONG_WIDTH 64
+
+#include <pthread.h>
+#include <sched.h>
+#include "unity.h"
+#include "circular-byte-buffer.h"
+
+#define STRESS_BUFFER_SIZE  64
+#define STRESS_BYTES        1000000UL
+#define STRESS_CHUNK        13
+
+static circ_bbuf_t buffer;
+
+void setUp(void)
+{
+    circ_bbuf_create_buffer(&buffer, STRESS_BUFFER_SIZE);
+}
+
+void tearDown(void)
+{
+    free(buffer.buffer);
+}
+
+// Producer : ISR side, pushes a known sequence mixing single and bulk pushes
+static void *producer_thread(void *arg)
+{
+    uint8_t chunk[STRESS_CHUNK];
+    uint32_t sent = 0;
+    (void)arg;
+
+    while(sent < STRESS_BYTES){
+        if(sent & 1){
+            if(circ_bbuf_push(&buffer, (uint8_t)sent) == CBB_SUCCESS) sent++;
+            else sched_yield();
+        }else{
+            uint32_t len = (STRESS_BYTES - sent < STRESS_CHUNK) ? STRESS_BYTES - sent : STRESS_CHUNK;
+            for(uint32_t i = 0; i < len; i++) chunk[i] = (uint8_t)(sent + i);
+            len = circ_bbuf_push_bytes_partial(&buffer, chunk, len);
+            if(len == 0) sched_yield();
+            sent += len;
+        }
+    }
+    return NULL;
+}
+
+void test_create_rounds_capacity_to_power_of_two(void)
+{
+    circ_bbuf_t rounded;
+
+    circ_bbuf_create_buffer(&rounded, 20);
+    TEST_ASSERT_EQUAL_UINT32(32, rounded.capacity);
+    TEST_ASSERT_EQUAL_UINT32(31, rounded.mask);
+    free(rounded.buffer);
+}
+
+void test_free_running_indexes_wrap(void)
+{
+    const uint8_t data_in[] = {1, 2, 3};
+    uint8_t data_out[3] = {0};
+
+    // Place indexes just before the 32 bits overflow
+    buffer.head = 0xFFFFFFFEUL;
+    buffer.tail = 0xFFFFFFFEUL;
+
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_push_bytes(&buffer, data_in, 3));
+    TEST_ASSERT_EQUAL_UINT32(3, circ_bbuf_available_bytes_to_read(&buffer));
+    TEST_ASSERT_EQUAL_UINT8(CBB_SUCCESS, circ_bbuf_pop_bytes(&buffer, 3, data_out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data_in, data_out, 3);
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&buffer));
+}
+
+void test_stress_producer_against_consumer(void)
+{
+    pthread_t producer;
+    uint8_t chunk[STRESS_CHUNK];
+    uint32_t received = 0;
+    uint32_t errors = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, producer_thread, NULL));
+
+    // Consumer : main loop side, checks the sequence is received without loss nor duplicate
+    while(received < STRESS_BYTES){
+        uint8_t data;
+        if(received & 1){
+            uint32_t len = circ_bbuf_pop_bytes_partial(&buffer, STRESS_CHUNK, chunk);
+            for(uint32_t i = 0; i < len; i++){
+                if(chunk[i] != (uint8_t)(received + i)) errors++;
+            }
+            if(len == 0) sched_yield();
+            received += len;
+        }else if(circ_bbuf_pop(&buffer, &data) == CBB_SUCCESS){
+            if(data != (uint8_t)received) errors++;
+            received++;
+        }else{
+            sched_yield();
+        }
+    }
+
+    pthread_join(producer, NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&buffer));
+}
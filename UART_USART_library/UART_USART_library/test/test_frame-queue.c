@@ -0,0 +1,192 @@
+#define UNITY_LONG_WIDTH 64
+
+#include <string.h>
+
+#include "unity.h"
+#include "circular-byte-buffer.h"
+#include "frame-queue.h"
+
+#define PORT    3
+
+static circ_bbuf_t bytes;
+static uint8_t bytes_storage[8];
+static frame_queue_t queue;
+static frame_desc_t desc_storage[2];
+
+static void push_frame(const char *data, uint8_t expected_end)
+{
+    while(*data != '\0'){
+        fq_push(&queue, (uint8_t)*data++);
+    }
+    TEST_ASSERT_EQUAL_UINT8(expected_end, fq_end(&queue));
+}
+
+static void assert_next_frame(const char *expected)
+{
+    frame_desc_t frame;
+    uint8_t *data[2];
+    uint32_t length[2];
+    uint8_t copy[8];
+
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_peek(&queue, &frame));
+    TEST_ASSERT_EQUAL_UINT32(strlen(expected), frame.length);
+    fq_frame_data(&queue, &frame, data, length);
+    memcpy(copy, data[0], length[0]);
+    memcpy(copy + length[0], data[1], length[1]);
+    TEST_ASSERT_EQUAL_MEMORY(expected, copy, frame.length);
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_release(&queue));
+}
+
+void setUp(void)
+{
+    circ_bbuf_init_buffer(&bytes, bytes_storage, sizeof(bytes_storage));
+    fq_init_queue(&queue, &bytes, desc_storage, 2, PORT);
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_bytes_are_published_with_their_descriptor(void)
+{
+    frame_desc_t frame;
+
+    fq_set_timestamp(&queue, 1234);
+    fq_push(&queue, 'A');
+    fq_push(&queue, 'B');
+    fq_add_errors(&queue, 0x04);
+    TEST_ASSERT_EQUAL_UINT32(2, fq_pending_length(&queue));
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+    TEST_ASSERT_EQUAL_UINT8(FQ_EMPTY, fq_peek(&queue, &frame));
+
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_end(&queue));
+    TEST_ASSERT_EQUAL_UINT32(2, circ_bbuf_available_bytes_to_read(&bytes));
+    TEST_ASSERT_EQUAL_UINT32(1, fq_available_frames(&queue));
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_peek(&queue, &frame));
+    TEST_ASSERT_EQUAL_UINT64(1234, frame.timestamp);
+    TEST_ASSERT_EQUAL_UINT32(0, frame.start);
+    TEST_ASSERT_EQUAL_UINT8(0x04, frame.errors);
+    TEST_ASSERT_EQUAL_UINT8(PORT, frame.port);
+
+    assert_next_frame("AB");
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+    TEST_ASSERT_EQUAL_UINT8(FQ_EMPTY, fq_end(&queue));
+}
+
+void test_frame_wrapping_around_the_storage_is_given_in_two_parts(void)
+{
+    push_frame("ABCDEF", FQ_SUCCESS);
+    assert_next_frame("ABCDEF");
+
+    push_frame("GHIJ", FQ_SUCCESS);
+    assert_next_frame("GHIJ");
+}
+
+void test_bytes_overflow_drops_the_whole_frame(void)
+{
+    push_frame("ABCDE", FQ_SUCCESS);
+
+    // 3 bytes left : the frame is dropped on its fourth byte, following ones are ignored
+    fq_push(&queue, 'F');
+    fq_push(&queue, 'G');
+    fq_push(&queue, 'H');
+    TEST_ASSERT_EQUAL_UINT8(FQ_BYTES_FULL, fq_push(&queue, 'I'));
+    TEST_ASSERT_EQUAL_UINT8(FQ_FRAME_DROPPED, fq_push(&queue, 'J'));
+    TEST_ASSERT_EQUAL_UINT32(0, fq_pending_length(&queue));
+    TEST_ASSERT_EQUAL_UINT8(FQ_FRAME_DROPPED, fq_end(&queue));
+
+    push_frame("XY", FQ_SUCCESS);
+    assert_next_frame("ABCDE");
+    assert_next_frame("XY");
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+}
+
+void test_descriptors_overflow_drops_the_whole_frame(void)
+{
+    frame_desc_t frame;
+
+    push_frame("AB", FQ_SUCCESS);
+    push_frame("CD", FQ_SUCCESS);
+    push_frame("EF", FQ_DESC_FULL);
+
+    // Bytes of the dropped frame are released with the next frame
+    assert_next_frame("AB");
+    push_frame("GH", FQ_SUCCESS);
+    assert_next_frame("CD");
+    assert_next_frame("GH");
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+    TEST_ASSERT_EQUAL_UINT8(FQ_EMPTY, fq_peek(&queue, &frame));
+}
+
+void test_dropped_frame_alone_releases_its_bytes(void)
+{
+    frame_desc_t frame;
+
+    push_frame("AB", FQ_SUCCESS);
+    push_frame("CD", FQ_SUCCESS);
+    push_frame("EF", FQ_DESC_FULL);
+    assert_next_frame("AB");
+    assert_next_frame("CD");
+
+    // Bytes left by the dropped frame fill the storage : next frame is dropped too, with an empty descriptor
+    push_frame("GHIJKLM", FQ_FRAME_DROPPED);
+    TEST_ASSERT_EQUAL_UINT8(FQ_EMPTY, fq_peek(&queue, &frame));
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+
+    push_frame("NOPQRST", FQ_SUCCESS);
+    assert_next_frame("NOPQRST");
+}
+
+void test_external_producer_overrun_drops_the_overwritten_frames(void)
+{
+    // DMA writes into the storage on its own, frames are closed by the idle line
+    memcpy(bytes_storage, "ABCDEF", 6);
+    TEST_ASSERT_EQUAL_UINT32(6, fq_advance_to(&queue, 6));
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_end(&queue));
+
+    // 5 bytes received with 2 bytes left : ABC has been written over, nothing is added and the frame is dropped
+    TEST_ASSERT_EQUAL_UINT32(0, fq_advance_to(&queue, 3));
+    TEST_ASSERT_EQUAL_UINT8(FQ_FRAME_DROPPED, fq_end(&queue));
+    TEST_ASSERT_EQUAL_UINT32(0, fq_pending_length(&queue));
+
+    // Reader drops the overwritten frame, the next one starts at the DMA position
+    fq_reset_to(&queue, 3, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, fq_available_frames(&queue));
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+    memcpy(&bytes_storage[3], "XY", 2);
+    TEST_ASSERT_EQUAL_UINT32(2, fq_advance_to(&queue, 5));
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_end(&queue));
+    assert_next_frame("XY");
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+}
+
+void test_reset_in_a_frame_drops_it_until_its_end(void)
+{
+    memcpy(bytes_storage, "ABC", 3);
+    TEST_ASSERT_EQUAL_UINT32(3, fq_advance_to(&queue, 3));
+
+    // Frame in progress has lost bytes : what comes after the reset is not given
+    fq_reset_to(&queue, 5, 1);
+    memcpy(&bytes_storage[5], "DE", 2);
+    fq_advance_to(&queue, 7);
+    TEST_ASSERT_EQUAL_UINT32(0, fq_pending_length(&queue));
+    TEST_ASSERT_EQUAL_UINT8(FQ_FRAME_DROPPED, fq_end(&queue));
+
+    // Next frame is whole
+    memcpy(&bytes_storage[7], "F", 1);
+    memcpy(bytes_storage, "G", 1);
+    TEST_ASSERT_EQUAL_UINT32(2, fq_advance_to(&queue, 1));
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_end(&queue));
+    assert_next_frame("FG");
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&bytes));
+}
+
+void test_create_rounds_descriptors_to_power_of_two(void)
+{
+    frame_queue_t rounded;
+
+    TEST_ASSERT_EQUAL_UINT8(FQ_SUCCESS, fq_create_queue(&rounded, &bytes, 20, PORT));
+    TEST_ASSERT_EQUAL_UINT32(32, rounded.capacity);
+    free(rounded.desc);
+}
@@ -0,0 +1,153 @@
+#define UNITY_LONG_WIDTH 64
+
+#include <stdio.h>
+#include "unity.h"
+#include "bench_cycles.h"
+#include "circular-byte-buffer.h"
+#include "frame-queue.h"
+
+// Same sizes as serial_mdw.h
+#define BENCH_BUFFER_SIZE           256
+#define BENCH_TIMESTAMP_SIZE        32
+#define BENCH_FRAME_SIZE            16
+#define BENCH_ITERATIONS            20000
+
+/*
+ * Reference : generic path (status byte, compare-and-reset on wrap),
+ * as it was before power-of-two capacities were enforced, with the bytes and
+ * the timestamps of the frames in two separate buffers.
+ */
+typedef struct {
+    uint8_t * buffer;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t capacity;
+    uint8_t buffer_status;
+} generic_bbuf_t;
+
+typedef struct {
+    uint64_t timestamp;
+    uint32_t position;
+    uint32_t length;
+} generic_timestamp_t;
+
+typedef struct {
+    generic_timestamp_t * buffer;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t capacity;
+    uint8_t buffer_status;
+} generic_tstp_t;
+
+// Not inlined, to be compared fairly with the library functions
+__attribute__((noinline)) static uint8_t generic_bbuf_push(generic_bbuf_t *c, uint8_t data)
+{
+    uint8_t result = CBB_SUCCESS;
+
+    if(c->buffer_status != CBB_BUFFER_FULL)
+    {
+        c->buffer[c->head++] = data;
+        c->buffer_status = CBB_BUFFER_FILLING;
+        if(c->head >= c->capacity) c->head = 0;
+    }else
+    {
+        result = CBB_BUFFER_FULL;
+    }
+    if(c->head == c->tail && c->buffer_status == CBB_BUFFER_FILLING) c->buffer_status = CBB_BUFFER_FULL;
+
+    return result;
+}
+
+__attribute__((noinline)) static uint32_t generic_bbuf_available(generic_bbuf_t *c)
+{
+    if (c->tail > c->head) return c->capacity - c->tail + c->head;
+    if (c->head == c->tail && c->buffer_status == CBB_BUFFER_FULL) return c->capacity;
+    return c->head - c->tail;
+}
+
+__attribute__((noinline)) static uint8_t generic_tstp_push(generic_tstp_t *c, generic_timestamp_t *data)
+{
+    uint8_t result = CBB_SUCCESS;
+
+    if(c->buffer_status != CBB_BUFFER_FULL)
+    {
+        c->buffer[c->head++] = *data;
+        c->buffer_status = CBB_BUFFER_FILLING;
+        if(c->head >= c->capacity) c->head = 0;
+    }else
+    {
+        result = CBB_BUFFER_FULL;
+    }
+    if(c->head == c->tail && c->buffer_status == CBB_BUFFER_FILLING) c->buffer_status = CBB_BUFFER_FULL;
+
+    return result;
+}
+
+static uint8_t bench_bytes[BENCH_BUFFER_SIZE];
+static generic_timestamp_t bench_timestamps[BENCH_TIMESTAMP_SIZE];
+static frame_desc_t bench_frames[BENCH_TIMESTAMP_SIZE];
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_benchmark_isr_path_frame_queue_against_generic(void)
+{
+    generic_bbuf_t generic_rx = {.buffer = bench_bytes, .capacity = BENCH_BUFFER_SIZE, .buffer_status = CBB_BUFFER_EMPTY};
+    generic_tstp_t generic_tstp = {.buffer = bench_timestamps, .capacity = BENCH_TIMESTAMP_SIZE, .buffer_status = CBB_BUFFER_EMPTY};
+    generic_timestamp_t timestamp = {.timestamp = 0, .position = 0, .length = BENCH_FRAME_SIZE};
+    circ_bbuf_t rx;
+    frame_queue_t frames;
+    frame_desc_t drain_frame;
+    uint64_t start, generic_cycles = 0, queue_cycles = 0;
+    volatile uint32_t fill = 0;
+    char message[128];
+
+    circ_bbuf_create_buffer(&rx, BENCH_BUFFER_SIZE);
+    fq_init_queue(&frames, &rx, bench_frames, BENCH_TIMESTAMP_SIZE, 0);
+
+    for(uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+        // ISR path : one push per received byte, fill level check, timestamp at end of frame
+        start = bench_cycles();
+        for(uint32_t j = 0; j < BENCH_BUFFER_SIZE / 2; j++){
+            generic_bbuf_push(&generic_rx, (uint8_t)j);
+            fill = generic_bbuf_available(&generic_rx);
+            if((j % BENCH_FRAME_SIZE) == BENCH_FRAME_SIZE - 1) generic_tstp_push(&generic_tstp, &timestamp);
+        }
+        generic_cycles += bench_cycles() - start;
+
+        // Frame queue of serial_mdw : bytes and descriptor are published together at end of frame
+        start = bench_cycles();
+        for(uint32_t j = 0; j < BENCH_BUFFER_SIZE / 2; j++){
+            fq_push(&frames, (uint8_t)j);
+            fill = fq_pending_length(&frames);
+            if((j % BENCH_FRAME_SIZE) == BENCH_FRAME_SIZE - 1) fq_end(&frames);
+        }
+        queue_cycles += bench_cycles() - start;
+
+        // Main loop path, not measured
+        generic_rx.tail = generic_rx.head;
+        generic_rx.buffer_status = CBB_BUFFER_EMPTY;
+        generic_tstp.tail = generic_tstp.head;
+        generic_tstp.buffer_status = CBB_BUFFER_EMPTY;
+        while(fq_peek(&frames, &drain_frame) == FQ_SUCCESS) fq_release(&frames);
+    }
+
+    TEST_ASSERT_TRUE(circ_bbuf_is_empty(&rx));
+    TEST_ASSERT_EQUAL_UINT32(0, fq_available_frames(&frames));
+    (void)fill;
+
+    snprintf(message, sizeof(message), "ISR path per byte (size %u), generic: %.2f cycles, frame queue: %.2f cycles",
+        BENCH_BUFFER_SIZE,
+        (double)generic_cycles / ((double)BENCH_ITERATIONS * BENCH_BUFFER_SIZE / 2),
+        (double)queue_cycles / ((double)BENCH_ITERATIONS * BENCH_BUFFER_SIZE / 2));
+    TEST_MESSAGE(message);
+
+    free(rx.buffer);
+}
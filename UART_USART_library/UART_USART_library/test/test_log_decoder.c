@@ -0,0 +1,126 @@
+#define UNITY_LONG_WIDTH 64
+
+#include <string.h>
+
+#include "unity.h"
+#include "logger.h"
+#include "logger_format.h"
+#include "log_decoder.h"
+#include "timebase.h"
+
+static const char file_name[] = "main.c";
+static const char format[] = "%s %d %lu";
+static const char *firmware_strings[] = {file_name, format};
+
+static log_decoder_t decoder;
+static char lines[4][LOG_DECODER_LINE_MAX_LENGTH];
+static uint32_t line_count;
+
+// Strings of the firmware : the ones of this test, found by their address truncated to 32 bits as on the target
+static const char *lookup(uint32_t address, void *context)
+{
+    (void)context;
+    for(uint32_t i = 0; i < sizeof(firmware_strings) / sizeof(firmware_strings[0]); i++)
+    {
+        if((uint32_t)(uintptr_t)firmware_strings[i] == address) return firmware_strings[i];
+    }
+    return NULL;
+}
+
+static void output(const char *line, void *context)
+{
+    (void)context;
+    if(line_count < 4) strcpy(lines[line_count], line);
+    line_count++;
+}
+
+// Record the way log_info does and give its binary form
+static uint32_t encode_next_record(uint8_t *wire, uint32_t timestamp, const char *fmt, uint32_t value)
+{
+    log_record_t record;
+
+    timebase_test_counter = timestamp;
+    log_record(LOG_INFO, file_name, 42, fmt, "uart", -3, (unsigned long)value);
+    TEST_ASSERT_EQUAL_UINT8(1, logger_pop_record(&record));
+    return logger_encode_record(&record, wire);
+}
+
+void setUp(void)
+{
+    log_record_t record;
+
+    logger_set_log_level(LOG_TRACE);
+    while(logger_pop_record(&record));
+    log_decoder_init(&decoder, lookup, output, NULL);
+    line_count = 0;
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_record_split_anywhere_is_decoded(void)
+{
+    uint8_t wire[LOGGER_WIRE_MAX_SIZE];
+    uint32_t length = encode_next_record(wire, 1234, format, 7);
+
+    TEST_ASSERT_EQUAL_UINT32(LOGGER_WIRE_SIZE(5 + 4 + 4), length);
+    TEST_ASSERT_EQUAL_HEX8(LOGGER_WIRE_SYNC_0, wire[0]);
+    TEST_ASSERT_EQUAL_HEX8(LOGGER_WIRE_SYNC_1, wire[1]);
+
+    log_decoder_push(&decoder, wire, 5);
+    TEST_ASSERT_EQUAL_UINT32(0, line_count);
+    log_decoder_push(&decoder, &wire[5], length - 5);
+    TEST_ASSERT_EQUAL_UINT32(1, line_count);
+    TEST_ASSERT_EQUAL_STRING("0.001234 INFO  main.c:42: uart -3 7", lines[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, decoder.errors);
+}
+
+void test_corrupted_record_is_skipped(void)
+{
+    uint8_t wire[3 * LOGGER_WIRE_MAX_SIZE];
+    uint32_t length = 0;
+
+    // Noise with a sync, a record with a wrong checksum, then a good one
+    wire[length++] = 0x00;
+    wire[length++] = LOGGER_WIRE_SYNC_0;
+    wire[length++] = 0x12;
+    length += encode_next_record(&wire[length], 10, format, 1);
+    wire[length - 3] ^= 0x01;
+    length += encode_next_record(&wire[length], 20, format, 2);
+
+    log_decoder_push(&decoder, wire, length);
+    TEST_ASSERT_EQUAL_UINT32(1, line_count);
+    TEST_ASSERT_EQUAL_STRING("0.000020 INFO  main.c:42: uart -3 2", lines[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, decoder.errors);
+    TEST_ASSERT_EQUAL_UINT32(1, decoder.records);
+}
+
+void test_timestamp_is_extended_and_drops_are_reported(void)
+{
+    uint8_t wire[LOGGER_WIRE_MAX_SIZE];
+    log_record_t dropped;
+    uint32_t count = 5;
+
+    log_decoder_push(&decoder, wire, encode_next_record(wire, 0xFFFFFF00u, format, 1));
+    // Counter has wrapped (71 minutes)
+    log_decoder_push(&decoder, wire, encode_next_record(wire, 0x100, format, 2));
+
+    // Record written by logger_process for the records lost by the ring
+    memset(&dropped, 0, sizeof(dropped));
+    dropped.timestamp = 0x200;
+    dropped.level = LOG_WARN;
+    dropped.length = sizeof(count);
+    memcpy(dropped.args, &count, sizeof(count));
+    log_decoder_push(&decoder, wire, logger_encode_record(&dropped, wire));
+
+    // Format missing from the firmware
+    log_decoder_push(&decoder, wire, encode_next_record(wire, 0x300, "%s %d %lu", 3));
+
+    TEST_ASSERT_EQUAL_UINT32(4, line_count);
+    TEST_ASSERT_EQUAL_STRING("4294.967040 INFO  main.c:42: uart -3 1", lines[0]);
+    TEST_ASSERT_EQUAL_STRING("4294.967552 INFO  main.c:42: uart -3 2", lines[1]);
+    TEST_ASSERT_EQUAL_STRING("4294.967808 WARN  ?:0: 5 log records dropped", lines[2]);
+    TEST_ASSERT_EQUAL_UINT32(0, strncmp("4294.968064 INFO  main.c:42: unknown format 0x", lines[3], 46));
+}
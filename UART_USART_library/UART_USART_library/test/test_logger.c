@@ -0,0 +1,249 @@
+#define UNITY_LONG_WIDTH 64
+// Macros of this file : records in the ring, TRACE removed at compile time
+#define LOGGER_DEFERRED
+#define LOG_COMPILE_LEVEL 1
+
+#include <string.h>
+
+#include "unity.h"
+#include "logger.h"
+#include "logger_format.h"
+#include "timebase.h"
+
+static char text[LOGGER_MESSAGE_MAX_LENGTH];
+
+static void assert_next_record(const char *expected)
+{
+    log_record_t record;
+
+    TEST_ASSERT_EQUAL_UINT8(1, logger_pop_record(&record));
+    logger_format_args(text, sizeof(text), record.fmt, record.args, record.length, record.truncated);
+    TEST_ASSERT_EQUAL_STRING(expected, text);
+}
+
+// Sink keeping what it is given
+static char sink_text[512];
+static uint32_t sink_length;
+static uint32_t sink_calls;
+
+static void capture_sink(const uint8_t *data, uint32_t length, void *context)
+{
+    (void)context;
+    memcpy(&sink_text[sink_length], data, length);
+    sink_length += length;
+    sink_text[sink_length] = '\0';
+    sink_calls++;
+}
+
+void setUp(void)
+{
+    log_record_t record;
+
+    logger_set_log_level(LOG_TRACE);
+    while(logger_pop_record(&record));
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_record_is_formatted_as_printf(void)
+{
+    const char *name = "uart";
+    char changing[8] = "before";
+    log_record_t record;
+
+    timebase_test_counter = 1234;
+    log_record(LOG_INFO, "main.c", 42, "%s %d %5lu %llu %c %x", name, -3, 123456ul, 1ull << 40, 'z', 0xBEEFu);
+    log_record(LOG_INFO, "main.c", 42, "%.2f %*d %% %p %hu", 3.14159, 4, 12, (void *)0x20400000, (unsigned short)7);
+    log_record(LOG_DEBUG, "main.c", 43, "%s", changing);
+    // Strings are copied with the call
+    strcpy(changing, "after");
+
+    TEST_ASSERT_EQUAL_UINT8(1, logger_pop_record(&record));
+    TEST_ASSERT_EQUAL_UINT32(1234, record.timestamp);
+    TEST_ASSERT_EQUAL_UINT8(LOG_INFO, record.level);
+    TEST_ASSERT_EQUAL_UINT16(42, record.line);
+    TEST_ASSERT_EQUAL_UINT8(0, record.truncated);
+    logger_format_args(text, sizeof(text), record.fmt, record.args, record.length, record.truncated);
+    TEST_ASSERT_EQUAL_STRING("uart -3 123456 1099511627776 z beef", text);
+    assert_next_record("3.14   12 % 0x20400000 7");
+
+    assert_next_record("before");
+    TEST_ASSERT_EQUAL_UINT8(0, logger_pop_record(&record));
+}
+
+void test_record_below_log_level_is_ignored(void)
+{
+    log_record_t record;
+
+    logger_set_log_level(LOG_WARN);
+    log_record(LOG_INFO, "main.c", 1, "ignored");
+    log_record(LOG_ERROR, "main.c", 2, "kept");
+
+    assert_next_record("kept");
+    TEST_ASSERT_EQUAL_UINT8(0, logger_pop_record(&record));
+}
+
+void test_arguments_which_do_not_fit_are_marked(void)
+{
+    static const char long_string[] = "0123456789012345678901234567890123456789";
+
+    log_record(LOG_INFO, "main.c", 1, "%llu %llu %llu %llu %llu %d", 1ull, 2ull, 3ull, 4ull, 5ull, 6);
+    log_record(LOG_INFO, "main.c", 2, "%d <%s> %d", 1, long_string, 2);
+
+    assert_next_record("1 2 3 4 5 ...");
+    assert_next_record("1 <01234567890123456789012345678901234...");
+}
+
+void test_string_without_terminator_is_missing(void)
+{
+    // Arguments of a decoded record, the string isn't terminated before the end of the record
+    static const uint8_t args[] = {'u', 'a', 'r', 't', '\0', 'a', 'b', 'c'};
+
+    logger_format_args(text, sizeof(text), "<%s> <%s> %d", args, sizeof(args), 0);
+    TEST_ASSERT_EQUAL_STRING("<uart> <...", text);
+    logger_format_args(text, sizeof(text), "<%s>", args, 4, 0);
+    TEST_ASSERT_EQUAL_STRING("<...", text);
+}
+
+void test_full_ring_drops_and_counts_records(void)
+{
+    uint32_t dropped = logger_dropped_records();
+
+    for(uint32_t i = 0; i < LOGGER_DEFERRED_RECORDS + 2; i++)
+    {
+        log_record(LOG_INFO, "main.c", 1, "%lu", (unsigned long)i);
+    }
+    TEST_ASSERT_EQUAL_UINT32(dropped + 2, logger_dropped_records());
+
+    // Oldest records are kept, in order, and slots are given back for the next lap
+    assert_next_record("0");
+    log_record(LOG_INFO, "main.c", 1, "next lap");
+    TEST_ASSERT_EQUAL_UINT32(LOGGER_DEFERRED_RECORDS, logger_process(LOGGER_DEFERRED_RECORDS + 1));
+    TEST_ASSERT_EQUAL_UINT32(0, logger_process(1));
+}
+
+static uint32_t evaluated;
+
+static int count_evaluation(void)
+{
+    return (int)++evaluated;
+}
+
+void test_levels_below_compile_level_are_removed(void)
+{
+    log_record_t record;
+
+    evaluated = 0;
+    log_trace("%d", count_evaluation());
+    log_debug("%d", count_evaluation());
+    logger_set_log_level(LOG_INFO);
+    log_debug("%d", count_evaluation());
+    log_info("%d", count_evaluation());
+
+    // Removed call doesn't evaluate its arguments, runtime filter still applies to the others
+    TEST_ASSERT_EQUAL_UINT32(3, evaluated);
+    assert_next_record("1");
+    assert_next_record("3");
+    TEST_ASSERT_EQUAL_UINT8(0, logger_pop_record(&record));
+}
+
+void test_dump_is_written_in_parts_of_whole_bytes(void)
+{
+    const uint8_t data[] = {0, 7, 42, 100, 255, 0xA5};
+    char part[12];
+    size_t offset = 0;
+
+    TEST_ASSERT_EQUAL_UINT32(20, logger_dump(text, sizeof(text), data, sizeof(data), &offset, LOGGER_DUMP_DECIMAL));
+    TEST_ASSERT_EQUAL_STRING("<0:7:42:100:255:165>", text);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(data), offset);
+
+    offset = 0;
+    logger_dump(text, sizeof(text), data, sizeof(data), &offset, LOGGER_DUMP_HEX);
+    TEST_ASSERT_EQUAL_STRING("<00:07:2a:64:ff:a5>", text);
+
+    // '>' has to fit with the last byte
+    offset = 0;
+    TEST_ASSERT_EQUAL_UINT32(11, logger_dump(part, sizeof(part), data, sizeof(data), &offset, LOGGER_DUMP_DECIMAL));
+    TEST_ASSERT_EQUAL_STRING("<0:7:42:100", part);
+    TEST_ASSERT_EQUAL_UINT32(4, offset);
+    logger_dump(part, sizeof(part), data, sizeof(data), &offset, LOGGER_DUMP_DECIMAL);
+    TEST_ASSERT_EQUAL_STRING(":255:165>", part);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(data), offset);
+
+    offset = 0;
+    logger_dump(part, sizeof(part), data, 0, &offset, LOGGER_DUMP_HEX);
+    TEST_ASSERT_EQUAL_STRING("<>", part);
+    TEST_ASSERT_EQUAL_UINT32(0, logger_dump(part, 1, data, sizeof(data), &offset, LOGGER_DUMP_HEX));
+    TEST_ASSERT_EQUAL_UINT32(0, offset);
+}
+
+void test_sinks_get_their_levels_in_batches(void)
+{
+    uint8_t post_mortem[LOGGER_RAM_RING_SIZE];
+    uint32_t length;
+    int8_t capture;
+    int8_t ram;
+
+    sink_length = 0;
+    sink_calls = 0;
+    logger_ram_ring_clear();
+    capture = logger_add_sink(capture_sink, NULL, LOG_WARN);
+    ram = logger_add_sink(logger_sink_ram_ring, NULL, LOG_TRACE);
+    TEST_ASSERT_TRUE(capture >= 0 && ram >= 0 && capture != ram);
+    // Same sink again only changes its level
+    TEST_ASSERT_EQUAL_INT(capture, logger_add_sink(capture_sink, NULL, LOG_WARN));
+
+    timebase_test_counter = 5;
+    log_record(LOG_INFO, "main.c", 1, "info");
+    log_record(LOG_WARN, "main.c", 2, "warn");
+    log_record(LOG_ERROR, "main.c", 3, "error\r\n");
+    TEST_ASSERT_EQUAL_UINT32(3, logger_process(LOGGER_DEFERRED_RECORDS));
+
+    // Lines at or above the level of the sink, ended once, in one call
+    TEST_ASSERT_EQUAL_UINT32(1, sink_calls);
+    TEST_ASSERT_EQUAL_STRING("5 WARN  main.c:2: warn\n5 ERROR main.c:3: error\r\n", sink_text);
+
+    // Written at the log call
+    logger_set_sink_level(capture, LOG_ERROR);
+    log_log(LOG_WARN, "main.c", 4, "not for capture");
+    log_log(LOG_FATAL, "main.c", 5, "fatal");
+    TEST_ASSERT_EQUAL_UINT32(2, sink_calls);
+    logger_remove_sink(capture);
+    log_log(LOG_FATAL, "main.c", 6, "removed");
+    TEST_ASSERT_EQUAL_UINT32(2, sink_calls);
+
+    length = logger_ram_ring_read(post_mortem, sizeof(post_mortem));
+    logger_remove_sink(ram);
+    post_mortem[length] = '\0';
+    TEST_ASSERT_EQUAL_UINT32(0, strncmp("5 INFO  main.c:1: info\n5 WARN  main.c:2: warn\n", (const char *)post_mortem, 46));
+    TEST_ASSERT_EQUAL_UINT32(0, strcmp("FATAL main.c:6: removed\n", (const char *)&post_mortem[length - 24]));
+
+    // Only the most recent bytes are kept
+    logger_ram_ring_clear();
+    for(uint32_t i = 0; i < LOGGER_RAM_RING_SIZE + 10; i++) logger_sink_ram_ring((const uint8_t *)"0123456789", 1, NULL);
+    TEST_ASSERT_EQUAL_UINT32(4, logger_ram_ring_read(post_mortem, 4));
+    TEST_ASSERT_EQUAL_MEMORY("0000", post_mortem, 4);
+}
+
+void test_truncated_message_is_written_without_its_terminator(void)
+{
+    char message[LOGGER_MESSAGE_MAX_LENGTH + 16];
+    int8_t capture;
+
+    memset(message, 'x', sizeof(message) - 1);
+    message[sizeof(message) - 1] = '\0';
+    sink_length = 0;
+    sink_calls = 0;
+    capture = logger_add_sink(capture_sink, NULL, LOG_TRACE);
+    log_log(LOG_INFO, "main.c", 1, "%s", message);
+    logger_remove_sink(capture);
+
+    // Whole buffer used, its '\0' replaced by the end of line
+    TEST_ASSERT_EQUAL_UINT32(1, sink_calls);
+    TEST_ASSERT_EQUAL_UINT32(LOGGER_MESSAGE_MAX_LENGTH, sink_length);
+    TEST_ASSERT_NULL(memchr(sink_text, '\0', sink_length));
+    TEST_ASSERT_EQUAL_UINT8('\n', sink_text[sink_length - 1]);
+}
@@ -0,0 +1,88 @@
+#define UNITY_LONG_WIDTH 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "bench_cycles.h"
+#include "logger_format.h"
+
+// Frame of serial_mdw read by the main loop, message size of the target
+#define BENCH_FRAME_SIZE            16
+#define BENCH_MESSAGE_LENGTH        100
+#define BENCH_ITERATIONS            20000
+
+/*
+ * Reference : log_buffer as it was, one snprintf per byte in an allocated buffer.
+ * The buffer is freed here, main.c never did.
+ */
+__attribute__((noinline)) static char * reference_log_buffer(uint8_t *p_buff, uint8_t buffer_length)
+{
+    uint8_t length = 0;
+    char *buffer = (char*) malloc(BENCH_MESSAGE_LENGTH * sizeof(char));
+
+    length += snprintf(buffer + length, BENCH_MESSAGE_LENGTH, "<");
+
+    for(uint8_t i=0; i<buffer_length; i++){
+        length += snprintf(buffer + length, BENCH_MESSAGE_LENGTH, "%u:", *p_buff);
+        p_buff++;
+    }
+    if(buffer_length > 0)
+    {
+        length += snprintf(buffer + length, BENCH_MESSAGE_LENGTH, "\b>");
+    }else
+    {
+        length += snprintf(buffer + length, BENCH_MESSAGE_LENGTH, ">");
+    }
+
+    return buffer;
+}
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_benchmark_dump_against_log_buffer(void)
+{
+    uint8_t frame[BENCH_FRAME_SIZE];
+    char text[BENCH_MESSAGE_LENGTH];
+    char *reference;
+    uint64_t start, reference_cycles = 0, dump_cycles = 0, hex_cycles = 0;
+    volatile size_t written = 0;
+    size_t offset;
+    char message[160];
+
+    for(uint32_t i = 0; i < BENCH_ITERATIONS; i++){
+        // Every byte value, one to three digits
+        for(uint32_t j = 0; j < BENCH_FRAME_SIZE; j++) frame[j] = (uint8_t)(i * 7 + j * 31);
+
+        start = bench_cycles();
+        reference = reference_log_buffer(frame, BENCH_FRAME_SIZE);
+        free(reference);
+        reference_cycles += bench_cycles() - start;
+
+        start = bench_cycles();
+        offset = 0;
+        written = logger_dump(text, sizeof(text), frame, BENCH_FRAME_SIZE, &offset, LOGGER_DUMP_DECIMAL);
+        dump_cycles += bench_cycles() - start;
+
+        start = bench_cycles();
+        offset = 0;
+        written = logger_dump(text, sizeof(text), frame, BENCH_FRAME_SIZE, &offset, LOGGER_DUMP_HEX);
+        hex_cycles += bench_cycles() - start;
+        TEST_ASSERT_EQUAL_UINT32(BENCH_FRAME_SIZE, offset);
+    }
+    (void)written;
+
+    snprintf(message, sizeof(message), "Dump of %u bytes, log_buffer: %.1f cycles, logger_dump decimal: %.1f cycles, hex: %.1f cycles",
+        BENCH_FRAME_SIZE,
+        (double)reference_cycles / BENCH_ITERATIONS,
+        (double)dump_cycles / BENCH_ITERATIONS,
+        (double)hex_cycles / BENCH_ITERATIONS);
+    TEST_MESSAGE(message);
+}
@@ -0,0 +1,109 @@
+#include "unity.h"
+#include "serial_dma.h"
+
+#include <string.h>
+
+// XDMAC register model : channel registers are plain RAM
+static Xdmac xdmac_model;
+static serial_dma_descriptor_t descriptor;
+static uint8_t ring[64];
+static uint32_t rhr;
+
+void setUp(void)
+{
+    memset(&xdmac_model, 0, sizeof(xdmac_model));
+    memset(&descriptor, 0, sizeof(descriptor));
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_rx_start_programs_channel(void)
+{
+    serial_dma_rx_start(&xdmac_model, 3, SERIAL_DMA_PERID_USART1_RX, &rhr, ring, sizeof(ring), &descriptor);
+
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_GD_DI0 << 3, xdmac_model.XDMAC_GD);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_GE_EN0 << 3, xdmac_model.XDMAC_GE);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CC_PERID(SERIAL_DMA_PERID_USART1_RX), xdmac_model.XDMAC_CHID[3].XDMAC_CC & XDMAC_CC_PERID_Msk);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CC_DSYNC_PER2MEM, xdmac_model.XDMAC_CHID[3].XDMAC_CC & XDMAC_CC_DSYNC);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CC_DAM_INCREMENTED_AM, xdmac_model.XDMAC_CHID[3].XDMAC_CC & XDMAC_CC_DAM_Msk);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CC_SAM_FIXED_AM, xdmac_model.XDMAC_CHID[3].XDMAC_CC & XDMAC_CC_SAM_Msk);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&descriptor, xdmac_model.XDMAC_CHID[3].XDMAC_CNDA);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CNDC_NDE_DSCR_FETCH_EN, xdmac_model.XDMAC_CHID[3].XDMAC_CNDC & XDMAC_CNDC_NDE);
+    // Laps are followed by the end of block interrupt
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CIE_BIE, xdmac_model.XDMAC_CHID[3].XDMAC_CIE);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_GIE_IE0 << 3, xdmac_model.XDMAC_GIE);
+    // Other channels are untouched
+    TEST_ASSERT_EQUAL_UINT32(0, xdmac_model.XDMAC_CHID[2].XDMAC_CC);
+}
+
+void test_rx_descriptor_is_linked_to_itself(void)
+{
+    serial_dma_rx_start(&xdmac_model, 0, SERIAL_DMA_PERID_UART0_RX, &rhr, ring, sizeof(ring), &descriptor);
+
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&descriptor, descriptor.mbr_nda);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&rhr, descriptor.mbr_sa);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)ring, descriptor.mbr_da);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(ring), SERIAL_DMA_UBC_UBLEN(descriptor.mbr_ubc));
+    TEST_ASSERT_TRUE(descriptor.mbr_ubc & SERIAL_DMA_UBC_NDE);
+    TEST_ASSERT_TRUE(descriptor.mbr_ubc & SERIAL_DMA_UBC_NDEN);
+}
+
+void test_rx_position_follows_microblock_counter(void)
+{
+    serial_dma_rx_start(&xdmac_model, 1, SERIAL_DMA_PERID_UART1_RX, &rhr, ring, sizeof(ring), &descriptor);
+
+    // Descriptor loaded, nothing received
+    xdmac_model.XDMAC_CHID[1].XDMAC_CUBC = sizeof(ring);
+    TEST_ASSERT_EQUAL_UINT32(0, serial_dma_rx_position(&xdmac_model, 1, sizeof(ring)));
+    // 10 bytes written by the DMA
+    xdmac_model.XDMAC_CHID[1].XDMAC_CUBC = sizeof(ring) - 10;
+    TEST_ASSERT_EQUAL_UINT32(10, serial_dma_rx_position(&xdmac_model, 1, sizeof(ring)));
+    // End of the microblock, before the descriptor is fetched again
+    xdmac_model.XDMAC_CHID[1].XDMAC_CUBC = 0;
+    TEST_ASSERT_EQUAL_UINT32(0, serial_dma_rx_position(&xdmac_model, 1, sizeof(ring)));
+}
+
+void test_rx_wrapped_reads_end_of_block(void)
+{
+    serial_dma_rx_start(&xdmac_model, 2, SERIAL_DMA_PERID_UART2_RX, &rhr, ring, sizeof(ring), &descriptor);
+    TEST_ASSERT_FALSE(serial_dma_rx_wrapped(&xdmac_model, 2));
+
+    // Set by the model when the channel goes back to the beginning of the ring
+    *(uint32_t *)&xdmac_model.XDMAC_CHID[2].XDMAC_CIS = XDMAC_CIS_BIS;
+    TEST_ASSERT_TRUE(serial_dma_rx_wrapped(&xdmac_model, 2));
+}
+
+void test_stop_disables_only_its_channel(void)
+{
+    serial_dma_stop(&xdmac_model, 5);
+
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_GD_DI5, xdmac_model.XDMAC_GD);
+}
+
+void test_tx_start_programs_single_block(void)
+{
+    serial_dma_tx_start(&xdmac_model, 10, SERIAL_DMA_PERID_UART2_TX, &rhr, ring, 17);
+
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)ring, xdmac_model.XDMAC_CHID[10].XDMAC_CSA);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&rhr, xdmac_model.XDMAC_CHID[10].XDMAC_CDA);
+    TEST_ASSERT_EQUAL_UINT32(17, xdmac_model.XDMAC_CHID[10].XDMAC_CUBC);
+    TEST_ASSERT_EQUAL_UINT32(0, xdmac_model.XDMAC_CHID[10].XDMAC_CNDC);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CC_PERID(SERIAL_DMA_PERID_UART2_TX), xdmac_model.XDMAC_CHID[10].XDMAC_CC & XDMAC_CC_PERID_Msk);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CC_DSYNC_MEM2PER, xdmac_model.XDMAC_CHID[10].XDMAC_CC & XDMAC_CC_DSYNC);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CC_SAM_INCREMENTED_AM, xdmac_model.XDMAC_CHID[10].XDMAC_CC & XDMAC_CC_SAM_Msk);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_CIE_BIE, xdmac_model.XDMAC_CHID[10].XDMAC_CIE);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_GIE_IE10, xdmac_model.XDMAC_GIE);
+    TEST_ASSERT_EQUAL_UINT32(XDMAC_GE_EN10, xdmac_model.XDMAC_GE);
+}
+
+void test_tx_completed_reads_end_of_block(void)
+{
+    TEST_ASSERT_FALSE(serial_dma_tx_completed(&xdmac_model, 10));
+
+    // Status register is read-only for the firmware, set by the model
+    *(uint32_t *)&xdmac_model.XDMAC_CHID[10].XDMAC_CIS = XDMAC_CIS_BIS;
+    TEST_ASSERT_TRUE(serial_dma_tx_completed(&xdmac_model, 10));
+}
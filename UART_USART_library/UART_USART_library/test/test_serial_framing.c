@@ -0,0 +1,120 @@
+#include "unity.h"
+#include "serial_framing.h"
+
+static serial_framing_t framing;
+static uint8_t frame[32];
+static uint32_t frame_length;
+static uint32_t frames;
+
+// Gives every byte to the engine, stored bytes are kept until the end of the first frame
+static void receive(const uint8_t *bytes, uint32_t length)
+{
+    uint8_t data;
+
+    for(uint32_t i = 0; i < length; i++){
+        uint8_t result = serial_framing_receive(&framing, bytes[i], &data);
+        if((result & SERIAL_FRAMING_DATA) && frames == 0) frame[frame_length++] = data;
+        if(result & SERIAL_FRAMING_END) frames++;
+    }
+}
+
+void setUp(void)
+{
+    frame_length = 0;
+    frames = 0;
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_invalid_configurations_are_rejected(void)
+{
+    serial_framing_conf_t conf = {.mode = SERIAL_FRAMING_DELIMITER, .delimiter_length = 0};
+
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_framing_init(&framing, &conf));
+    conf.delimiter_length = SERIAL_FRAMING_MAX_DELIMITER + 1;
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_framing_init(&framing, &conf));
+    conf.mode = SERIAL_FRAMING_LENGTH;
+    conf.length_size = 3;
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_framing_init(&framing, &conf));
+    conf.mode = SERIAL_FRAMING_IDLE;
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_framing_init(&framing, &conf));
+}
+
+void test_crlf_delimiter(void)
+{
+    const serial_framing_conf_t conf = {.mode = SERIAL_FRAMING_DELIMITER, .delimiter = {'\r', '\n'}, .delimiter_length = 2};
+    const uint8_t received[] = {'o', 'k', '\r', 'x', '\r', '\r', '\n', 'n', 'e'};
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_framing_init(&framing, &conf));
+    receive(received, sizeof(received));
+
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT32(7, frame_length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(received, frame, 7);
+}
+
+void test_length_prefixed_frames(void)
+{
+    const serial_framing_conf_t conf = {.mode = SERIAL_FRAMING_LENGTH, .length_size = 2};
+    const uint8_t received[] = {0x00, 0x03, 'a', 'b', 'c', 0x00, 0x00, 0x00, 0x01, 'd'};
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_framing_init(&framing, &conf));
+    receive(received, sizeof(received));
+
+    // Header is kept, empty frame is still a frame
+    TEST_ASSERT_EQUAL_UINT32(3, frames);
+    TEST_ASSERT_EQUAL_UINT32(5, frame_length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(received, frame, 5);
+}
+
+void test_slip_frames_are_decoded(void)
+{
+    const serial_framing_conf_t conf = {.mode = SERIAL_FRAMING_SLIP};
+    const uint8_t received[] = {SERIAL_FRAMING_SLIP_END, 0x01, SERIAL_FRAMING_SLIP_ESC, SERIAL_FRAMING_SLIP_ESC_END,
+                                SERIAL_FRAMING_SLIP_ESC, SERIAL_FRAMING_SLIP_ESC_ESC, 0x02, SERIAL_FRAMING_SLIP_END};
+    const uint8_t expected[] = {0x01, SERIAL_FRAMING_SLIP_END, SERIAL_FRAMING_SLIP_ESC, 0x02};
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_framing_init(&framing, &conf));
+    // Leading END closes an empty frame
+    receive(received, 1);
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT32(0, frame_length);
+
+    frames = 0;
+    receive(&received[1], sizeof(received) - 1);
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), frame_length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame, sizeof(expected));
+}
+
+void test_cobs_frames_are_decoded(void)
+{
+    const serial_framing_conf_t conf = {.mode = SERIAL_FRAMING_COBS};
+    // 11 22 00 33 encoded
+    const uint8_t received[] = {0x03, 0x11, 0x22, 0x02, 0x33, 0x00};
+    const uint8_t expected[] = {0x11, 0x22, 0x00, 0x33};
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_framing_init(&framing, &conf));
+    receive(received, sizeof(received));
+
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), frame_length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame, sizeof(expected));
+}
+
+void test_cobs_without_zero_in_long_block(void)
+{
+    const serial_framing_conf_t conf = {.mode = SERIAL_FRAMING_COBS};
+    // 00 encoded as 01 01, frame ended
+    const uint8_t received[] = {0x01, 0x01, 0x00};
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_framing_init(&framing, &conf));
+    receive(received, sizeof(received));
+
+    TEST_ASSERT_EQUAL_UINT32(1, frames);
+    TEST_ASSERT_EQUAL_UINT32(1, frame_length);
+    TEST_ASSERT_EQUAL_UINT8(0x00, frame[0]);
+}
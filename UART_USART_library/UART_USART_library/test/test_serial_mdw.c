@@ -1,17 +1,183 @@
 #define UNITY_LONG_WIDTH 64
 
+#include <string.h>
+
 #include "unity.h"
 #include "logger.h"
+#include "logger_format.h"
 #include "circular-byte-buffer.h"
-#include "timestamp-buffer.h"
+#include "frame-queue.h"
 #include "serial_mdw.h"
+#include "serial_framing.h"
+#include "timebase.h"
 #include "mock_uart.h"
 #include "mock_usart.h"
 #include "mock_pmc.h"
+#include "mock_serial_dma.h"
 
-void setUp(void)
+// Interrupt handlers of serial_mdw
+void XDMAC_Handler(void);
+void UART1_Handler(void);
+void UART3_Handler(void);
+void UART0_Handler(void);
+void UART4_Handler(void);
+void USART0_Handler(void);
+void USART2_Handler(void);
+
+static serial_mdw_handle_t handle_uart0;
+static serial_mdw_handle_t handle_usart1;
+static serial_mdw_handle_t handle_uart2;
+static serial_mdw_handle_t handle_uart1;
+static serial_mdw_handle_t handle_uart3;
+static serial_mdw_handle_t handle_usart0;
+static serial_mdw_handle_t handle_usart2;
+static serial_mdw_handle_t handle_uart4;
+
+// UART1 model : 6 bytes are already received when the interrupt is entered
+static const uint8_t uart1_rx_frame[] = {'a', 'b', 'c', 'd', 'e', 'f'};
+static uint32_t uart1_rx_index = 0;
+static uint32_t uart1_tx_count = 0;
+
+static uint32_t uart1_get_status(Uart *p_uart, int cmock_num_calls)
+{
+    uint32_t status = UART_SR_TXRDY;
+
+    if(uart1_rx_index < sizeof(uart1_rx_frame)) status |= UART_SR_RXRDY;
+
+    return status;
+}
+static uint32_t uart1_read(Uart *p_uart, uint8_t *puc_data, int cmock_num_calls)
+{
+    *puc_data = uart1_rx_frame[uart1_rx_index++];
+    return 0;
+}
+static uint32_t uart1_write(Uart *p_uart, const uint8_t uc_data, int cmock_num_calls)
+{
+    uart1_tx_count++;
+    return 0;
+}
+
+// UART3 model : overrun and framing error flagged on the first status read, then uart3_rx_count bytes received
+static uint32_t uart3_rx_count = 0;
+
+static uint32_t uart3_get_status(Uart *p_uart, int cmock_num_calls)
+{
+    uint32_t status = 0;
+
+    if(cmock_num_calls == 0) status |= UART_SR_OVRE | UART_SR_FRAME;
+    if(uart3_rx_count != 0) status |= UART_SR_RXRDY;
+
+    return status;
+}
+static uint32_t uart3_read(Uart *p_uart, uint8_t *puc_data, int cmock_num_calls)
+{
+    *puc_data = (uint8_t)cmock_num_calls;
+    uart3_rx_count--;
+    return 0;
+}
+
+// Generic reception model : rx_model_data is received, one byte per read
+static const uint8_t *rx_model_data;
+static uint32_t rx_model_length = 0;
+
+static uint32_t rx_model_get_status(Uart *p_uart, int cmock_num_calls)
+{
+    return (rx_model_length != 0) ? UART_SR_RXRDY : 0;
+}
+static uint32_t rx_model_read(Uart *p_uart, uint8_t *puc_data, int cmock_num_calls)
+{
+    *puc_data = *rx_model_data++;
+    rx_model_length--;
+    return 0;
+}
+static void rx_model_receive(const uint8_t *data, uint32_t length)
+{
+    rx_model_data = data;
+    rx_model_length = length;
+    uart_get_status_StubWithCallback(rx_model_get_status);
+    uart_read_StubWithCallback(rx_model_read);
+}
+
+// UART4 model : parity error flagged on the first status read, then rx_model_data is received
+static uint32_t uart4_get_status(Uart *p_uart, int cmock_num_calls)
+{
+    return rx_model_get_status(p_uart, cmock_num_calls) | ((cmock_num_calls == 0) ? UART_SR_PARE : 0);
+}
+
+// USART reception model : line is idle once every byte has been read
+static uint32_t usart_rx_model_get_status(Usart *p_usart, int cmock_num_calls)
+{
+    return (rx_model_length != 0) ? US_CSR_RXRDY : US_CSR_TIMEOUT;
+}
+static uint32_t usart_rx_model_read(Usart *p_usart, uint32_t *pul_data, int cmock_num_calls)
 {
+    *pul_data = *rx_model_data++;
+    rx_model_length--;
+    return 0;
+}
 
+static uint32_t usart_idle_get_status(Usart *p_usart, int cmock_num_calls)
+{
+    return US_CSR_TIMEOUT;
+}
+static uint32_t usart_busy_get_status(Usart *p_usart, int cmock_num_calls)
+{
+    return 0;
+}
+
+// Callbacks : every call adds its context
+static uint8_t tx_done_count = 0;
+static void tx_done(void *context)
+{
+    tx_done_count += *(uint8_t *)context;
+}
+static serial_mdw_handle_t notified_handle;
+static uint32_t notified_count = 0;
+static void rx_notified(serial_mdw_handle_t handle, void *context)
+{
+    notified_handle = handle;
+    notified_count += *(uint32_t *)context;
+}
+
+static const usart_serial_options_t serial_option = {
+    .baudrate = 115200ul,
+    .charlength = US_MR_CHRL_8_BIT,
+    .paritytype = US_MR_PAR_NO,
+    .stopbits = US_MR_NBSTOP_1_BIT
+};
+
+// UART without DMA
+static void init_uart(usart_if p_usart, UART_timestamp_t activate_timestamp, serial_mdw_handle_t *p_handle)
+{
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    uart_init_ExpectAnyArgsAndReturn(0);
+    uart_enable_interrupt_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface(p_usart, &serial_option, activate_timestamp, DMA_NOT_USED, p_handle));
+}
+// USART receiving by DMA, with its receiver time-out
+static void init_usart_dma_rx(usart_if p_usart, UART_timestamp_t activate_timestamp, serial_mdw_handle_t *p_handle)
+{
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    usart_init_rs232_ExpectAnyArgsAndReturn(0);
+    usart_enable_rx_ExpectAnyArgs();
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    serial_dma_rx_start_ExpectAnyArgs();
+    usart_set_rx_timeout_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    usart_enable_interrupt_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface(p_usart, &serial_option, activate_timestamp, DMA_RX_USED, p_handle));
+}
+
+void setUp(void)
+{
+    // Every test initializes the interfaces it uses
+    serial_mdw_test_reset();
+    uart1_rx_index = 0;
+    uart1_tx_count = 0;
+    uart3_rx_count = 0;
+    rx_model_length = 0;
+    tx_done_count = 0;
+    notified_count = 0;
 }
 
 void tearDown(void)
@@ -26,11 +192,653 @@ void test_init(void)
     uart_init_ExpectAnyArgsAndReturn(0);
     uart_enable_interrupt_ExpectAnyArgs();
 
-    const usart_serial_options_t serial_option = {
-    .baudrate = 115200ul,
-    .charlength = US_MR_CHRL_8_BIT,
-    .paritytype = US_MR_PAR_NO,
-    .stopbits = US_MR_NBSTOP_1_BIT
-	};
-    serial_mdw_init_interface((usart_if)UART0, &serial_option, TIMESTAMP_USED);
-}
\ No newline at end of file
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)UART0, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &handle_uart0));
+    TEST_ASSERT_EQUAL_UINT8(0, handle_uart0.slot);
+    TEST_ASSERT_EQUAL_UINT8(SERIAL_MDW_UART, handle_uart0.type);
+}
+void test_init_twice_is_rejected(void)
+{
+    serial_mdw_handle_t handle;
+
+    init_uart((usart_if)UART0, TIMESTAMP_USED, &handle_uart0);
+    TEST_ASSERT_EQUAL(ERR_BUSY, serial_mdw_init_interface((usart_if)UART0, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &handle));
+    TEST_ASSERT_EQUAL_PTR(handle_uart0.p_usart, handle.p_usart);
+    TEST_ASSERT_EQUAL_UINT8(handle_uart0.slot, handle.slot);
+}
+void test_init_unknown_interface_is_rejected(void)
+{
+    serial_mdw_handle_t handle;
+
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_init_interface((usart_if)UART0 + 1, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &handle));
+    TEST_ASSERT_EQUAL_UINT8(SERIAL_MDW_HANDLE_INVALID.slot, handle.slot);
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_init_interface((usart_if)UART3, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, NULL));
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_init_interface((usart_if)UART3, NULL, TIMESTAMP_USED, DMA_NOT_USED, &handle));
+    TEST_ASSERT_EQUAL_UINT8(SERIAL_MDW_HANDLE_INVALID.slot, handle.slot);
+}
+void test_invalid_handles_are_rejected(void)
+{
+    uint8_t frame[] = {1, 2, 3};
+    serial_mdw_handle_t forged;
+
+    init_uart((usart_if)UART0, TIMESTAMP_USED, &handle_uart0);
+    forged = handle_uart0;
+
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_send_bytes(SERIAL_MDW_HANDLE_INVALID, frame, sizeof(frame)));
+    // Slot and interface don't match
+    forged.slot = 3;
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_send_byte(forged, 0x55));
+    // Interface not initialized
+    forged.p_usart = (usart_if)UART3;
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_available_bytes(forged));
+    TEST_ASSERT_FALSE(serial_mdw_read_bytes(forged, frame, sizeof(frame)));
+}
+void test_init_dma_with_timestamp_on_uart_is_rejected(void)
+{
+    serial_mdw_handle_t handle;
+
+    // No receiver time-out to close the frames
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_init_interface((usart_if)UART4, &serial_option, TIMESTAMP_USED, DMA_RX_USED, &handle));
+}
+void test_dma_rx_bytes_are_published(void)
+{
+    // Expected
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    usart_init_rs232_ExpectAnyArgsAndReturn(0);
+    usart_enable_rx_ExpectAnyArgs();
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    serial_dma_rx_start_ExpectAnyArgs();
+    usart_set_rx_timeout_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    usart_enable_interrupt_ExpectAnyArgs();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)USART1, &serial_option, TIMESTAMP_NOT_USED, DMA_RX_USED, &handle_usart1));
+
+    // 10 bytes written by the DMA since the start
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(10);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL_UINT32(10, serial_mdw_available_bytes(handle_usart1));
+}
+void test_dma_tx_ring_and_caller_buffer(void)
+{
+    const uint8_t frame[] = {1, 2, 3, 4, 5};
+    uint8_t increment = 1;
+
+    // Expected
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    uart_init_ExpectAnyArgsAndReturn(0);
+    uart_enable_interrupt_ExpectAnyArgs();
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    uart_enable_tx_ExpectAnyArgs();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)UART2, &serial_option, TIMESTAMP_NOT_USED, DMA_TX_USED, &handle_uart2));
+
+    // Bytes copied into the TX buffer are sent by one transfer
+    serial_dma_tx_start_ExpectAnyArgs();
+    serial_mdw_send_bytes(handle_uart2, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(ERR_BUSY, serial_mdw_send_buffer(handle_uart2, frame, sizeof(frame), tx_done, &increment));
+
+    serial_dma_tx_completed_ExpectAnyArgsAndReturn(true);
+    XDMAC_Handler();
+
+    // Caller buffer is sent without copy
+    serial_dma_tx_start_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_send_buffer(handle_uart2, frame, sizeof(frame), tx_done, &increment));
+    TEST_ASSERT_EQUAL_UINT8(0, tx_done_count);
+
+    serial_dma_tx_completed_ExpectAnyArgsAndReturn(true);
+    XDMAC_Handler();
+    TEST_ASSERT_EQUAL_UINT8(1, tx_done_count);
+}
+void test_send_buffer_needs_dma(void)
+{
+    const uint8_t frame[] = {1, 2, 3};
+
+    init_uart((usart_if)UART0, TIMESTAMP_USED, &handle_uart0);
+    TEST_ASSERT_EQUAL(ERR_UNSUPPORTED_DEV, serial_mdw_send_buffer(handle_uart0, frame, sizeof(frame), NULL, NULL));
+}
+void test_isr_drains_rx_and_tx_in_one_entry(void)
+{
+    const uint8_t frame[] = {1, 2, 3, 4};
+    uint8_t received[6] = {0};
+    serial_mdw_isr_counters_t counters;
+    serial_mdw_stats_t stats;
+
+    // Expected
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    uart_init_ExpectAnyArgsAndReturn(0);
+    uart_enable_interrupt_ExpectAnyArgs();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)UART1, &serial_option, TIMESTAMP_NOT_USED, DMA_NOT_USED, &handle_uart1));
+
+    uart_enable_tx_Ignore();
+    uart_enable_interrupt_Ignore();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_send_bytes(handle_uart1, frame, sizeof(frame)));
+
+    uart_get_status_StubWithCallback(uart1_get_status);
+    uart_read_StubWithCallback(uart1_read);
+    uart_write_StubWithCallback(uart1_write);
+    UART1_Handler();
+
+    TEST_ASSERT_EQUAL_UINT32(sizeof(frame), uart1_tx_count);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(uart1_rx_frame), serial_mdw_available_bytes(handle_uart1));
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle_uart1, received, sizeof(received)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(uart1_rx_frame, received, sizeof(received));
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_isr_counters(handle_uart1, &counters));
+    TEST_ASSERT_EQUAL_UINT32(1, counters.isr_entries);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(uart1_rx_frame) + sizeof(frame), counters.max_bytes_per_entry);
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_uart1, &stats));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(uart1_rx_frame), stats.rx_bytes);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(frame), stats.tx_bytes);
+}
+void test_ready_mask_gives_interfaces_in_turn(void)
+{
+    const uint8_t bytes[] = {1, 2, 3};
+    const uint8_t frames[] = {'a', 'E', 'x', 'E'};
+    uint8_t received[10];
+    uint32_t length;
+    serial_mdw_handle_t handle;
+
+    init_uart((usart_if)UART0, TIMESTAMP_USED, &handle_uart0);
+    init_uart((usart_if)UART1, TIMESTAMP_NOT_USED, &handle_uart1);
+    init_usart_dma_rx((usart_if)USART1, TIMESTAMP_NOT_USED, &handle_usart1);
+    TEST_ASSERT_EQUAL_HEX32(0, serial_mdw_available());
+
+    // 10 bytes written by the DMA of USART1
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(10);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL_UINT32(10, serial_mdw_available_bytes(handle_usart1));
+    TEST_ASSERT_EQUAL_HEX32(1UL << handle_usart1.slot, serial_mdw_available());
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL_UINT8(handle_usart1.slot, handle.slot);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(10);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle, received, 10));
+    TEST_ASSERT_FALSE(serial_mdw_next_ready(&handle));
+
+    rx_model_receive(bytes, sizeof(bytes));
+    UART1_Handler();
+    rx_model_receive(frames, sizeof(frames));
+    UART0_Handler();
+    TEST_ASSERT_EQUAL_HEX32((1UL << handle_uart0.slot) | (1UL << handle_uart1.slot), serial_mdw_available());
+
+    // Interface stays ready until everything has been read, the other one is given in between
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL_UINT8(handle_uart0.slot, handle.slot);
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle, received, sizeof(received), &length, NULL));
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL_UINT8(handle_uart1.slot, handle.slot);
+    TEST_ASSERT_TRUE(serial_mdw_read_byte(handle, received));
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL_UINT8(handle_uart0.slot, handle.slot);
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle, received, sizeof(received), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(2, length);
+    TEST_ASSERT_EQUAL_HEX32(1UL << handle_uart1.slot, serial_mdw_available());
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL_UINT8(handle_uart1.slot, handle.slot);
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle, received, 2));
+
+    TEST_ASSERT_FALSE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL_HEX32(0, serial_mdw_available());
+}
+void test_stats_count_errors_drops_and_high_water(void)
+{
+    serial_mdw_stats_t stats;
+
+    // Expected
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    uart_init_ExpectAnyArgsAndReturn(0);
+    uart_enable_interrupt_ExpectAnyArgs();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)UART3, &serial_option, TIMESTAMP_NOT_USED, DMA_NOT_USED, &handle_uart3));
+
+    // More bytes than the RX buffer can hold, received with an overrun and a framing error
+    uart3_rx_count = SERIAL_MDW_BUFFER_SIZE + 10;
+    uart_get_status_StubWithCallback(uart3_get_status);
+    uart_read_StubWithCallback(uart3_read);
+    uart_reset_status_ExpectAnyArgs();
+    UART3_Handler();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_uart3, &stats));
+    TEST_ASSERT_EQUAL_UINT32(SERIAL_MDW_BUFFER_SIZE + 10, stats.rx_bytes);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.rx_dropped);
+    TEST_ASSERT_EQUAL_UINT32(SERIAL_MDW_BUFFER_SIZE, stats.rx_high_water);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overrun_errors);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.framing_errors);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.parity_errors);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.tx_bytes);
+
+    // High-water mark stays once the buffer has been read
+    TEST_ASSERT_EQUAL_UINT32(SERIAL_MDW_BUFFER_SIZE, serial_mdw_available_bytes(handle_uart3));
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_get_stats(SERIAL_MDW_HANDLE_INVALID, &stats));
+}
+void test_frame_read_copies_timestamped_frames(void)
+{
+    const uint8_t received[] = {'a', 'b', 'E', '1', '2', 'E'};
+    uint8_t frame[8];
+    uint32_t length;
+    serial_mdw_frame_t in_place;
+
+    init_uart((usart_if)UART0, TIMESTAMP_USED, &handle_uart0);
+    rx_model_receive(received, sizeof(received));
+    UART0_Handler();
+
+    // Frame is kept when it doesn't fit
+    TEST_ASSERT_EQUAL(ERR_NO_MEMORY, serial_mdw_frame_read(handle_uart0, frame, 2, &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(3, length);
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_uart0, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(3, length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(received, frame, 3);
+
+    // Second frame is read in place
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_peek(handle_uart0, &in_place));
+    TEST_ASSERT_EQUAL_UINT32(3, in_place.length[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, in_place.length[1]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&received[3], in_place.data[0], 3);
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_commit(handle_uart0, &in_place));
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_uart0, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(0, length);
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_timestamp_available(handle_uart0));
+}
+void test_frame_too_long_for_the_reader_is_dropped_in_place(void)
+{
+    const uint8_t received[] = {'a', 'b', 'c', 'd', 'E', 'x', 'E'};
+    uint8_t frame[2];
+    uint32_t length;
+    serial_mdw_handle_t handle;
+    serial_mdw_frame_t dropped;
+
+    init_uart((usart_if)UART0, TIMESTAMP_USED, &handle_uart0);
+    rx_model_receive(received, sizeof(received));
+    UART0_Handler();
+
+    // Read keeps the frame : the interface stays ready with it
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL(ERR_NO_MEMORY, serial_mdw_frame_read(handle, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(5, length);
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL_UINT8(handle_uart0.slot, handle.slot);
+
+    // Dropped in place as in the main loop : the next frame is given, then the interface isn't ready anymore
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_peek(handle, &dropped));
+    TEST_ASSERT_EQUAL_UINT32(5, dropped.length[0] + dropped.length[1]);
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_commit(handle, &dropped));
+    TEST_ASSERT_TRUE(serial_mdw_next_ready(&handle));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(2, length);
+    TEST_ASSERT_FALSE(serial_mdw_next_ready(&handle));
+}
+void test_frame_peek_gives_two_slices_when_wrapping(void)
+{
+    static uint8_t filled[SERIAL_MDW_BUFFER_SIZE];
+    const uint8_t received[] = {0x10, 0x11, 0x12, 0x13};
+    uint8_t frame[SERIAL_MDW_BUFFER_SIZE];
+    uint32_t length;
+    serial_mdw_frame_t in_place;
+
+    init_uart((usart_if)UART3, TIMESTAMP_NOT_USED, &handle_uart3);
+    for(uint32_t i = 0; i < sizeof(filled); i++) filled[i] = (uint8_t)i;
+    rx_model_receive(filled, sizeof(filled));
+    UART3_Handler();
+
+    // Reading stops 2 bytes before the end of the storage
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_uart3, frame, SERIAL_MDW_BUFFER_SIZE - 2, &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(SERIAL_MDW_BUFFER_SIZE - 2, length);
+
+    rx_model_receive(received, sizeof(received));
+    UART3_Handler();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_peek(handle_uart3, &in_place));
+    TEST_ASSERT_EQUAL_UINT32(2, in_place.length[0]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&filled[SERIAL_MDW_BUFFER_SIZE - 2], in_place.data[0], 2);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(received), in_place.length[1]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(received, in_place.data[1], sizeof(received));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_commit(handle_uart3, &in_place));
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_available_bytes(handle_uart3));
+}
+void test_set_framing_with_crlf_delimiter(void)
+{
+    const serial_framing_conf_t crlf = {.mode = SERIAL_FRAMING_DELIMITER, .delimiter = {'\r', '\n'}, .delimiter_length = 2};
+    const serial_framing_conf_t idle = {.mode = SERIAL_FRAMING_IDLE, .idle_bits = 40};
+    const uint8_t received[] = {'E', '\r', '\r', '\n'};
+    uint8_t frame[8];
+    uint32_t length;
+    serial_mdw_handle_t forged;
+
+    init_uart((usart_if)UART0, TIMESTAMP_USED, &handle_uart0);
+    init_uart((usart_if)UART3, TIMESTAMP_NOT_USED, &handle_uart3);
+    forged = handle_uart0;
+    forged.slot = 0xFE;
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_set_framing(forged, &crlf));
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_set_framing(handle_uart0, NULL));
+    TEST_ASSERT_EQUAL(ERR_UNSUPPORTED_DEV, serial_mdw_set_framing(handle_uart0, &idle));
+    TEST_ASSERT_EQUAL(ERR_UNSUPPORTED_DEV, serial_mdw_set_framing(handle_uart3, &crlf));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_set_framing(handle_uart0, &crlf));
+
+    rx_model_receive(received, sizeof(received));
+    UART0_Handler();
+
+    TEST_ASSERT_EQUAL_UINT32(1, serial_mdw_timestamp_available(handle_uart0));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_uart0, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(received), length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(received, frame, sizeof(received));
+}
+void test_idle_line_closes_frame_on_usart(void)
+{
+    const serial_framing_conf_t idle = {.mode = SERIAL_FRAMING_IDLE, .idle_bits = 40};
+    const uint8_t received[] = {0x01, 0x02, 0x03};
+    uint8_t frame[8];
+    uint32_t length;
+
+    // Expected
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    usart_init_rs232_ExpectAnyArgsAndReturn(0);
+    usart_enable_rx_ExpectAnyArgs();
+    usart_enable_interrupt_ExpectAnyArgs();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)USART0, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &handle_usart0));
+
+    usart_set_rx_timeout_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    usart_enable_interrupt_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_set_framing(handle_usart0, &idle));
+
+    rx_model_data = received;
+    rx_model_length = sizeof(received);
+    usart_get_status_StubWithCallback(usart_rx_model_get_status);
+    usart_read_StubWithCallback(usart_rx_model_read);
+    USART0_Handler();
+
+    // Time-out comes after the last byte, it closes the frame in the next entry
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_timestamp_available(handle_usart0));
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART0_Handler();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_usart0, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(received), length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(received, frame, sizeof(received));
+}
+void test_dma_rx_frames_are_closed_by_idle_line(void)
+{
+    const serial_framing_conf_t crlf = {.mode = SERIAL_FRAMING_DELIMITER, .delimiter = {'\r', '\n'}, .delimiter_length = 2};
+    uint8_t frame[16];
+    uint32_t length;
+
+    // Expected
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    usart_init_rs232_ExpectAnyArgsAndReturn(0);
+    usart_enable_rx_ExpectAnyArgs();
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    serial_dma_rx_start_ExpectAnyArgs();
+    usart_set_rx_timeout_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    usart_enable_interrupt_ExpectAnyArgs();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)USART2, &serial_option, TIMESTAMP_USED, DMA_RX_USED, &handle_usart2));
+    // Bytes aren't seen one by one
+    TEST_ASSERT_EQUAL(ERR_UNSUPPORTED_DEV, serial_mdw_set_framing(handle_usart2, &crlf));
+
+    // 5 bytes written by the DMA then the line is idle
+    usart_get_status_StubWithCallback(usart_idle_get_status);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(5);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART2_Handler();
+
+    TEST_ASSERT_EQUAL_UINT32(1, serial_mdw_timestamp_available(handle_usart2));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_usart2, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(5, length);
+}
+void test_frames_which_do_not_fit_are_dropped_whole(void)
+{
+    static uint8_t received[SERIAL_MDW_BUFFER_SIZE + 2];
+    const uint8_t with_error[] = {'x', 'E'};
+    serial_mdw_stats_t stats;
+    serial_mdw_frame_t in_place;
+
+    // Expected
+    pmc_enable_periph_clk_ExpectAnyArgsAndReturn(0);
+    uart_init_ExpectAnyArgsAndReturn(0);
+    uart_enable_interrupt_ExpectAnyArgs();
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_init_interface((usart_if)UART4, &serial_option, TIMESTAMP_USED, DMA_NOT_USED, &handle_uart4));
+
+    // Frame one byte longer than the RX buffer, with its delimiter
+    memset(received, 'a', sizeof(received) - 1);
+    received[sizeof(received) - 1] = 'E';
+    rx_model_receive(received, sizeof(received));
+    UART4_Handler();
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_timestamp_available(handle_uart4));
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_available_bytes(handle_uart4));
+
+    // Next frame is received with a parity error
+    rx_model_data = with_error;
+    rx_model_length = sizeof(with_error);
+    uart_get_status_StubWithCallback(uart4_get_status);
+    uart_reset_status_ExpectAnyArgs();
+    UART4_Handler();
+
+    TEST_ASSERT_EQUAL_UINT32(1, serial_mdw_timestamp_available(handle_uart4));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_peek(handle_uart4, &in_place));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(with_error), in_place.length[0] + in_place.length[1]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(with_error, in_place.data[0], in_place.length[0]);
+    TEST_ASSERT_EQUAL_UINT8(SERIAL_MDW_FRAME_PARITY, in_place.errors);
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_commit(handle_uart4, &in_place));
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_available_bytes(handle_uart4));
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_uart4, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.rx_dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.frames_timestamped);
+    TEST_ASSERT_EQUAL_UINT32(SERIAL_MDW_BUFFER_SIZE, stats.rx_high_water);
+}
+void test_rx_events_and_callback(void)
+{
+    const uint8_t frames[] = {'a', 'E', 'b', 'c', 'E', 'd'};
+    const uint8_t bytes[] = {1, 2, 3};
+    uint32_t weight = 1;
+    uint8_t received[sizeof(bytes)];
+    uint8_t frame[8];
+    uint32_t length;
+
+    init_uart((usart_if)UART1, TIMESTAMP_NOT_USED, &handle_uart1);
+    init_uart((usart_if)UART4, TIMESTAMP_USED, &handle_uart4);
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_set_rx_callback(SERIAL_MDW_HANDLE_INVALID, rx_notified, &weight));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_set_rx_callback(handle_uart4, rx_notified, &weight));
+
+    // Timestamped : one notification per complete frame, nothing for the frame in progress
+    rx_model_receive(frames, sizeof(frames));
+    UART4_Handler();
+    TEST_ASSERT_EQUAL_UINT32(2, notified_count);
+    TEST_ASSERT_EQUAL_PTR(handle_uart4.p_usart, notified_handle.p_usart);
+    TEST_ASSERT_EQUAL_UINT8(handle_uart4.slot, notified_handle.slot);
+
+    // Without timestamp : one notification per interrupt entry
+    rx_model_receive(bytes, sizeof(bytes));
+    UART1_Handler();
+    TEST_ASSERT_EQUAL_UINT32(2, notified_count);
+    TEST_ASSERT_EQUAL_HEX32((1UL << handle_uart4.slot) | (1UL << handle_uart1.slot), serial_mdw_wait_rx_events());
+    TEST_ASSERT_EQUAL_HEX32(0, serial_mdw_take_rx_events());
+
+    // Nothing is notified when nothing is received
+    UART1_Handler();
+    TEST_ASSERT_EQUAL_HEX32(0, serial_mdw_take_rx_events());
+
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle_uart1, received, sizeof(received)));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_uart4, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_uart4, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(3, length);
+}
+void test_rx_watermark_batches_notifications(void)
+{
+    const uint8_t bytes[] = {1, 2, 3, 4, 5};
+    uint8_t received[sizeof(bytes)];
+
+    init_uart((usart_if)UART1, TIMESTAMP_NOT_USED, &handle_uart1);
+    init_uart((usart_if)UART4, TIMESTAMP_USED, &handle_uart4);
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, serial_mdw_set_rx_watermark(handle_uart1, SERIAL_MDW_BUFFER_SIZE + 1, 0));
+    TEST_ASSERT_EQUAL(ERR_UNSUPPORTED_DEV, serial_mdw_set_rx_watermark(handle_uart4, 4, 0));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_set_rx_watermark(handle_uart1, 4, 10));
+
+    // Below the watermark : nothing is notified
+    rx_model_receive(bytes, 3);
+    UART1_Handler();
+    TEST_ASSERT_EQUAL_HEX32(0, serial_mdw_take_rx_events());
+    TEST_ASSERT_FALSE(serial_mdw_available() & (1UL << handle_uart1.slot));
+
+    // Watermark is crossed
+    rx_model_receive(&bytes[3], 2);
+    UART1_Handler();
+    TEST_ASSERT_EQUAL_HEX32(1UL << handle_uart1.slot, serial_mdw_take_rx_events());
+    TEST_ASSERT_TRUE(serial_mdw_available() & (1UL << handle_uart1.slot));
+
+    // Bytes left below the watermark are notified once they have waited for the time-out since the read
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle_uart1, received, 3));
+    TEST_ASSERT_FALSE(serial_mdw_available() & (1UL << handle_uart1.slot));
+    timebase_test_counter += 9999;
+    TEST_ASSERT_FALSE(serial_mdw_available() & (1UL << handle_uart1.slot));
+    timebase_test_counter += 1;
+    TEST_ASSERT_TRUE(serial_mdw_available() & (1UL << handle_uart1.slot));
+    TEST_ASSERT_EQUAL_HEX32(1UL << handle_uart1.slot, serial_mdw_take_rx_events());
+
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle_uart1, &received[3], 2));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, received, sizeof(bytes));
+    TEST_ASSERT_FALSE(serial_mdw_available() & (1UL << handle_uart1.slot));
+}
+void test_dma_rx_overrun_of_lagging_reader_is_resynchronized(void)
+{
+    uint8_t received[SERIAL_MDW_BUFFER_SIZE];
+    serial_mdw_stats_t stats;
+
+    // 10 bytes written by the DMA are read
+    init_usart_dma_rx((usart_if)USART1, TIMESTAMP_NOT_USED, &handle_usart1);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(10);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle_usart1, received, 10));
+
+    // 200 bytes written by the DMA, the reader only takes 50 of them
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(210);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL_UINT32(200, serial_mdw_available_bytes(handle_usart1));
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle_usart1, received, 50));
+
+    // DMA goes past the end of the ring and writes 150 bytes over 106 free ones
+    serial_dma_rx_wrapped_ExpectAnyArgsAndReturn(true);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(104);
+    XDMAC_Handler();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_usart1, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overrun_errors);
+    TEST_ASSERT_EQUAL_UINT32(150, stats.rx_dropped);
+
+    // Unread bytes are dropped by the reader, only the bytes written after the DMA position are given
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(110);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL_UINT32(6, serial_mdw_available_bytes(handle_usart1));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_usart1, &stats));
+    TEST_ASSERT_EQUAL_UINT32(300, stats.rx_dropped);
+
+    // A whole lap without any synchronization : the position is back where it was
+    serial_dma_rx_wrapped_ExpectAnyArgsAndReturn(true);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(110);
+    XDMAC_Handler();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_usart1, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.overrun_errors);
+    TEST_ASSERT_EQUAL_UINT32(300 + SERIAL_MDW_BUFFER_SIZE, stats.rx_dropped);
+
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(110);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_available_bytes(handle_usart1));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_usart1, &stats));
+    TEST_ASSERT_EQUAL_UINT32(306 + SERIAL_MDW_BUFFER_SIZE, stats.rx_dropped);
+
+    // Visible wrap without its interrupt yet is not an overrun
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(4);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    TEST_ASSERT_EQUAL_UINT32(150, serial_mdw_available_bytes(handle_usart1));
+    serial_dma_rx_wrapped_ExpectAnyArgsAndReturn(true);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(4);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    XDMAC_Handler();
+    TEST_ASSERT_TRUE(serial_mdw_read_bytes(handle_usart1, received, 150));
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_usart1, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.overrun_errors);
+}
+void test_dma_rx_overrun_drops_the_timestamped_frames_written_over(void)
+{
+    uint8_t frame[16];
+    uint32_t length;
+    serial_mdw_stats_t stats;
+
+    // A first frame of 5 bytes is read
+    init_usart_dma_rx((usart_if)USART2, TIMESTAMP_USED, &handle_usart2);
+    usart_get_status_StubWithCallback(usart_idle_get_status);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(5);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART2_Handler();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_usart2, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(5, length);
+
+    // A frame of 100 bytes is queued, 100 bytes of the next one are received
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(105);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART2_Handler();
+    usart_get_status_StubWithCallback(usart_busy_get_status);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(205);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    USART2_Handler();
+    TEST_ASSERT_EQUAL_UINT32(1, serial_mdw_timestamp_available(handle_usart2));
+
+    // 120 bytes over 56 free ones : the queued frame is written over
+    serial_dma_rx_wrapped_ExpectAnyArgsAndReturn(true);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(69);
+    XDMAC_Handler();
+
+    // End of the cut frame is dropped
+    usart_get_status_StubWithCallback(usart_idle_get_status);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(75);
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART2_Handler();
+
+    // Reader drops the queued frame, the next one is given whole
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_timestamp_available(handle_usart2));
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(85);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART2_Handler();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_usart2, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(10, length);
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_usart2, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overrun_errors);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(120 + 6 + 200, stats.rx_dropped);
+
+    // Reader drops the frame in progress before its end : its next bytes aren't given
+    usart_get_status_StubWithCallback(usart_busy_get_status);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(245);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    USART2_Handler();
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(100);
+    USART2_Handler();
+    TEST_ASSERT_EQUAL_UINT32(0, serial_mdw_timestamp_available(handle_usart2));
+
+    usart_get_status_StubWithCallback(usart_idle_get_status);
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(105);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART2_Handler();
+    serial_dma_rx_position_ExpectAnyArgsAndReturn(109);
+    serial_dma_invalidate_dcache_ExpectAnyArgs();
+    usart_start_rx_timeout_ExpectAnyArgs();
+    USART2_Handler();
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_frame_read(handle_usart2, frame, sizeof(frame), &length, NULL));
+    TEST_ASSERT_EQUAL_UINT32(4, length);
+
+    TEST_ASSERT_EQUAL(STATUS_OK, serial_mdw_get_stats(handle_usart2, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.overrun_errors);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.frames_dropped);
+}
@@ -0,0 +1,199 @@
+#define UNITY_LONG_WIDTH 64
+
+#include "unity.h"
+#include "timebase.h"
+
+// 300 MHz counter as on the SAME70 : 300 cycles per microsecond
+#define CPU_HZ          300000000UL
+#define CYCLES_PER_US   (CPU_HZ / 1000000UL)
+
+void setUp(void)
+{
+    timebase_test_counter = 1000;
+    timebase_init(CPU_HZ);
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_counts_microseconds_between_ticks(void)
+{
+    TEST_ASSERT_EQUAL_UINT64(0, timebase_monotonic_us());
+
+    timebase_test_counter += 250 * CYCLES_PER_US + CYCLES_PER_US / 2;
+    TEST_ASSERT_EQUAL_UINT64(250, timebase_monotonic_us());
+}
+
+void test_init_rejects_counter_below_one_mhz(void)
+{
+    timebase_test_counter += 40 * CYCLES_PER_US;
+
+    // Time base keeps counting with the previous frequency
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, timebase_init(999999UL));
+    TEST_ASSERT_EQUAL(ERR_INVALID_ARG, timebase_init(0));
+    TEST_ASSERT_EQUAL_UINT64(40, timebase_monotonic_us());
+    TEST_ASSERT_EQUAL(STATUS_OK, timebase_init(1000000UL));
+    timebase_test_counter += 40;
+    TEST_ASSERT_EQUAL_UINT64(40, timebase_monotonic_us());
+}
+
+void test_ticks_extend_the_counter_over_its_wrap(void)
+{
+    uint64_t expected_us = 0;
+
+    // 20 laps of the 32 bits counter, ticked every millisecond with a remainder of cycles
+    for(uint32_t i = 0; i < 20 * 14400; i++){
+        timebase_test_counter += 1000 * CYCLES_PER_US + 7;
+        timebase_tick();
+    }
+    expected_us = (uint64_t)20 * 14400 * (1000 * CYCLES_PER_US + 7) / CYCLES_PER_US;
+
+    TEST_ASSERT_EQUAL_UINT64(expected_us, timebase_monotonic_us());
+}
+
+void test_epoch_offsets_unix_time(void)
+{
+    const uint64_t unix_us = 1546300800000000ULL;    // 2019-01-01 00:00:00
+
+    timebase_test_counter += 10 * CYCLES_PER_US;
+    timebase_set_epoch_us(unix_us);
+    TEST_ASSERT_EQUAL_UINT64(unix_us, timebase_unix_us());
+
+    timebase_test_counter += 3 * CYCLES_PER_US;
+    TEST_ASSERT_EQUAL_UINT64(unix_us + 3, timebase_unix_us());
+    TEST_ASSERT_EQUAL_UINT64(13, timebase_monotonic_us());
+}
+
+// SysTick preempting a reader between the two reads of the sequence
+static uint32_t preemptions;
+static void tick_during_read(void)
+{
+    if(preemptions == 0) return;
+    preemptions--;
+    timebase_test_counter += 1000 * CYCLES_PER_US;
+    timebase_tick();
+}
+
+void test_reader_preempted_by_tick_reads_again(void)
+{
+    preemptions = 2;
+    timebase_test_read_hook = tick_during_read;
+
+    TEST_ASSERT_EQUAL_UINT64(2000, timebase_monotonic_us());
+    TEST_ASSERT_EQUAL_UINT32(0, preemptions);
+
+    timebase_test_read_hook = NULL;
+}
+
+void test_first_reference_steps_the_time(void)
+{
+    const uint64_t unix_us = 1546300800000000ULL;
+
+    timebase_test_counter += 10 * CYCLES_PER_US;
+    TEST_ASSERT_EQUAL_INT64((int64_t)(unix_us - 10), timebase_discipline(unix_us));
+    TEST_ASSERT_EQUAL_UINT64(unix_us, timebase_unix_us());
+    TEST_ASSERT_EQUAL_INT32(0, timebase_drift_ppb());
+}
+
+// One second of reference time on a counter drifting by drift_ppm, ticked every millisecond
+static void run_one_second(int32_t drift_ppm, uint64_t *p_last_us)
+{
+    for(uint32_t i = 0; i < 1000; i++){
+        timebase_test_counter += 1000 * CYCLES_PER_US + drift_ppm * (int32_t)CYCLES_PER_US / 1000;
+        timebase_tick();
+        TEST_ASSERT_TRUE(timebase_unix_us() >= *p_last_us);
+        *p_last_us = timebase_unix_us();
+    }
+}
+
+void test_drift_of_the_counter_is_estimated_and_slewed(void)
+{
+    const uint64_t unix_us = 1546300800000000ULL;
+    uint64_t last_us = 0;
+    int64_t offset_us = 0;
+
+    // Counter 50 ppm fast : 50 us too much every second
+    timebase_discipline(unix_us);
+    for(uint32_t second = 1; second <= 30; second++){
+        run_one_second(50, &last_us);
+        offset_us = timebase_discipline(unix_us + second * 1000000ULL);
+    }
+
+    TEST_ASSERT_INT64_WITHIN(2, 0, offset_us);
+    TEST_ASSERT_INT_WITHIN(1000, -50000, timebase_drift_ppb());
+}
+
+void test_big_offset_steps_the_time_again(void)
+{
+    const uint64_t unix_us = 1546300800000000ULL;
+
+    timebase_discipline(unix_us);
+    timebase_test_counter += 1000 * CYCLES_PER_US;
+    TEST_ASSERT_EQUAL_INT64(2000000 - 1000, timebase_discipline(unix_us + 2000000));
+    TEST_ASSERT_EQUAL_UINT64(unix_us + 2000000, timebase_unix_us());
+}
+
+void test_pps_edges_follow_the_seconds_of_the_reference(void)
+{
+    const uint64_t unix_us = 1546300800000000ULL;
+    uint64_t last_us = 0;
+    int64_t offset_us = 0;
+
+    // Epoch set 300 ms late by a RTC read, the first edge is aligned on the closest second
+    timebase_set_epoch_us(unix_us + 300000);
+    TEST_ASSERT_EQUAL_INT64(-300000, timebase_discipline_pps());
+    for(uint32_t second = 1; second <= 30; second++){
+        run_one_second(-20, &last_us);
+        offset_us = timebase_discipline_pps();
+    }
+
+    TEST_ASSERT_EQUAL_UINT64(unix_us + 30000000ULL, timebase_unix_us() - offset_us);
+    TEST_ASSERT_INT64_WITHIN(2, 0, offset_us);
+    TEST_ASSERT_INT_WITHIN(1000, 20000, timebase_drift_ppb());
+}
+
+void test_pps_missed_or_spurious_edge_keeps_the_seconds(void)
+{
+    const uint64_t unix_us = 1546300800000000ULL;
+    uint64_t last_us = 0;
+    int64_t offset_us;
+
+    timebase_set_epoch_us(unix_us);
+    TEST_ASSERT_EQUAL_INT64(0, timebase_discipline_pps());
+    run_one_second(0, &last_us);
+    TEST_ASSERT_EQUAL_INT64(0, timebase_discipline_pps());
+
+    // Missed edge : next one is two seconds later
+    run_one_second(0, &last_us);
+    run_one_second(0, &last_us);
+    TEST_ASSERT_EQUAL_INT64(0, timebase_discipline_pps());
+
+    // Spurious edges : in the second of the previous edge, then far from a second
+    timebase_test_counter += 1000 * CYCLES_PER_US;
+    TEST_ASSERT_EQUAL_INT64(TIMEBASE_PPS_REJECTED, timebase_discipline_pps());
+    timebase_test_counter += 600000 * CYCLES_PER_US;
+    TEST_ASSERT_EQUAL_INT64(TIMEBASE_PPS_REJECTED, timebase_discipline_pps());
+    timebase_test_counter += 399000 * CYCLES_PER_US;
+    offset_us = timebase_discipline_pps();
+    TEST_ASSERT_EQUAL_INT64(0, offset_us);
+    TEST_ASSERT_EQUAL_UINT64(unix_us + 4000000ULL, timebase_unix_us());
+}
+
+void test_pps_edges_moved_for_good_are_followed(void)
+{
+    const uint64_t unix_us = 1546300800000000ULL;
+
+    timebase_set_epoch_us(unix_us);
+    TEST_ASSERT_EQUAL_INT64(0, timebase_discipline_pps());
+
+    // Reference moved by 400 ms : edges are rejected, then followed
+    timebase_test_counter += 400000 * CYCLES_PER_US;
+    for(uint32_t i = 1; i < TIMEBASE_PPS_MAX_REJECTED; i++){
+        timebase_test_counter += 1000000 * CYCLES_PER_US;
+        TEST_ASSERT_EQUAL_INT64(TIMEBASE_PPS_REJECTED, timebase_discipline_pps());
+    }
+    timebase_test_counter += 1000000 * CYCLES_PER_US;
+    TEST_ASSERT_EQUAL_INT64(-400000, timebase_discipline_pps());
+}
@@ -0,0 +1,116 @@
+#define UNITY_LONG_WIDTH 64
+
+#include "unity.h"
+#include "timebase.h"
+#include "timebase_rtc.h"
+#include "mock_DS3231M.h"
+
+// Built with TIMEBASE_RTC_DS3231M (project.yml), against the DS3231M declarations of test/support
+#if !defined(TIMEBASE_RTC_DS3231M)
+#   error "timebase_rtc is tested with TIMEBASE_RTC_DS3231M defined"
+#endif
+
+// 300 MHz counter as on the SAME70 : 300 cycles per microsecond
+#define CPU_HZ          300000000UL
+#define CYCLES_PER_US   (CPU_HZ / 1000000UL)
+// Duration of one read of the RTC by I2C
+#define RTC_READ_US     500
+// 2019-01-01 00:00:00
+#define RTC_UNIX_S      1546300800ULL
+
+// RTC model : each read takes RTC_READ_US, the second changes on read rtc_edge_read (never when 0),
+// read rtc_error_read fails (never when 0)
+static uint64_t rtc_unix_s;
+static uint32_t rtc_reads;
+static uint32_t rtc_edge_read;
+static uint32_t rtc_error_read;
+
+static uint32_t rtc_get_time(ds3231m_t *ds3231m, int cmock_num_calls)
+{
+    rtc_reads++;
+    timebase_test_counter += RTC_READ_US * CYCLES_PER_US;
+    if(rtc_reads == rtc_error_read) return TWIHS_RECEIVE_NACK;
+    if(rtc_reads == rtc_edge_read) rtc_unix_s++;
+    ds3231m->second = (uint8_t)(rtc_unix_s % 60);
+    return TWIHS_SUCCESS;
+}
+static uint64_t rtc_to_unixms(ds3231m_t *ds3231m, int cmock_num_calls)
+{
+    TEST_ASSERT_EQUAL_UINT8(rtc_unix_s % 60, ds3231m->second);
+    return rtc_unix_s * 1000ULL;
+}
+
+void setUp(void)
+{
+    timebase_test_counter = 1000;
+    timebase_init(CPU_HZ);
+    rtc_unix_s = RTC_UNIX_S;
+    rtc_reads = 0;
+    rtc_edge_read = 0;
+    rtc_error_read = 0;
+    DS3231M_get_time_StubWithCallback(rtc_get_time);
+    convert_dateTime_to_unixms_StubWithCallback(rtc_to_unixms);
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_seed_is_taken_on_the_change_of_second(void)
+{
+    ds3231m_t rtc = {.address = DS3231_DEFAULT_ADDRESS};
+
+    rtc_edge_read = 5;
+    TEST_ASSERT_EQUAL(STATUS_OK, timebase_rtc_seed(&rtc));
+
+    // RTC is read until its second changes, the epoch is the new second in microseconds
+    TEST_ASSERT_EQUAL_UINT32(5, rtc_reads);
+    TEST_ASSERT_EQUAL_UINT64((RTC_UNIX_S + 1) * 1000000ULL, timebase_unix_us());
+    timebase_test_counter += 10 * CYCLES_PER_US;
+    TEST_ASSERT_EQUAL_UINT64((RTC_UNIX_S + 1) * 1000000ULL + 10, timebase_unix_us());
+}
+
+void test_seed_gives_up_when_the_second_does_not_change(void)
+{
+    ds3231m_t rtc = {.address = DS3231_DEFAULT_ADDRESS};
+
+    TEST_ASSERT_EQUAL(ERR_TIMEOUT, timebase_rtc_seed(&rtc));
+
+    // Waits a bit more than one second, epoch isn't set
+    TEST_ASSERT_UINT64_WITHIN(2 * RTC_READ_US, TIMEBASE_RTC_WAIT_US + RTC_READ_US, timebase_monotonic_us());
+    TEST_ASSERT_EQUAL_UINT64(timebase_monotonic_us(), timebase_unix_us());
+}
+
+void test_seed_stops_on_a_read_error(void)
+{
+    ds3231m_t rtc = {.address = DS3231_DEFAULT_ADDRESS};
+
+    rtc_error_read = 1;
+    TEST_ASSERT_EQUAL(ERR_IO_ERROR, timebase_rtc_seed(&rtc));
+    TEST_ASSERT_EQUAL_UINT32(1, rtc_reads);
+
+    // While waiting for the change of second
+    rtc_reads = 0;
+    rtc_error_read = 3;
+    TEST_ASSERT_EQUAL(ERR_IO_ERROR, timebase_rtc_seed(&rtc));
+    TEST_ASSERT_EQUAL_UINT32(3, rtc_reads);
+    TEST_ASSERT_EQUAL_UINT64(timebase_monotonic_us(), timebase_unix_us());
+}
+
+void test_discipline_gives_the_offset_of_the_rtc(void)
+{
+    ds3231m_t rtc = {.address = DS3231_DEFAULT_ADDRESS};
+    int64_t offset_us = 0;
+
+    rtc_edge_read = 2;
+    TEST_ASSERT_EQUAL(STATUS_OK, timebase_rtc_seed(&rtc));
+
+    // Time base is 300 us ahead on the next change of second, 2 s later
+    timebase_test_counter += (2000000 - 2 * RTC_READ_US + 300) * CYCLES_PER_US;
+    rtc_reads = 0;
+    rtc_unix_s++;
+    TEST_ASSERT_EQUAL(STATUS_OK, timebase_rtc_discipline(&rtc, &offset_us));
+    TEST_ASSERT_EQUAL_INT64(-300, offset_us);
+    TEST_ASSERT_EQUAL_UINT64((RTC_UNIX_S + 3) * 1000000ULL, timebase_unix_us());
+}
@@ -0,0 +1,71 @@
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf_strings.h"
+
+int elf_strings_load(elf_strings_t *elf, const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	Elf32_Ehdr header;
+	long size;
+
+	memset(elf, 0, sizeof(*elf));
+	if(file == NULL) return -1;
+	if(fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < (long)sizeof(header) || fseek(file, 0, SEEK_SET) != 0)
+	{
+		fclose(file);
+		return -1;
+	}
+	elf->data = (uint8_t *) malloc((size_t)size);
+	if(elf->data == NULL || fread(elf->data, 1, (size_t)size, file) != (size_t)size)
+	{
+		fclose(file);
+		elf_strings_free(elf);
+		return -1;
+	}
+	fclose(file);
+	elf->size = (size_t)size;
+
+	// Headers are read as they are : the host has to be little endian as the target
+	memcpy(&header, elf->data, sizeof(header));
+	if(memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS32 || header.e_ident[EI_DATA] != ELFDATA2LSB
+		|| header.e_shentsize < sizeof(Elf32_Shdr) || header.e_shoff > elf->size
+		|| (size_t)header.e_shnum * header.e_shentsize > elf->size - header.e_shoff)
+	{
+		elf_strings_free(elf);
+		return -1;
+	}
+	elf->sections = &elf->data[header.e_shoff];
+	elf->count = header.e_shnum;
+	elf->entry_size = header.e_shentsize;
+
+	return 0;
+}
+
+const char *elf_strings_lookup(uint32_t address, void *context)
+{
+	elf_strings_t *elf = (elf_strings_t *) context;
+	Elf32_Shdr section;
+
+	for(uint16_t i = 0; i < elf->count; i++)
+	{
+		memcpy(&section, &elf->sections[(size_t)i * elf->entry_size], sizeof(section));
+		if(section.sh_type != SHT_PROGBITS || (section.sh_flags & SHF_ALLOC) == 0) continue;
+		if(address < section.sh_addr || address - section.sh_addr >= section.sh_size) continue;
+		if(section.sh_offset > elf->size || section.sh_size > elf->size - section.sh_offset) return NULL;
+
+		const char *string = (const char *) &elf->data[section.sh_offset + (address - section.sh_addr)];
+		size_t left = section.sh_size - (address - section.sh_addr);
+		return (memchr(string, '\0', left) != NULL) ? string : NULL;
+	}
+
+	return NULL;
+}
+
+void elf_strings_free(elf_strings_t *elf)
+{
+	free(elf->data);
+	memset(elf, 0, sizeof(*elf));
+}
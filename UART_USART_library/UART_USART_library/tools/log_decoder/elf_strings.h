@@ -0,0 +1,55 @@
+/*
+							        *******************
+******************************* C HEADER FILE *******************************
+**                           *******************                           **
+**                                                                         **
+** project   : RAPTORS                                                     **
+** filename  : elf_strings                                                 **
+** date      : January 11, 2019                                            **
+** author    : Julien Delvaux                                              **
+** licence   : MIT                                                         **
+**                                                                         **
+*****************************************************************************
+Strings of a firmware (32 bits little endian ELF, as built by arm-none-eabi-gcc) found by their address,
+for log_decoder. Only the sections loaded on the target with content (.text, .rodata, ...) are searched.
+
+*/
+
+#ifndef ELF_STRINGS_H_
+#define ELF_STRINGS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+	uint8_t *data;				// whole file
+	size_t size;
+	const uint8_t *sections;	// section headers in data
+	uint16_t count;
+	uint16_t entry_size;
+} elf_strings_t;
+
+/**
+* Load a firmware
+* @param elf
+* @param path : ELF file
+* @return 0 on success, -1 when the file can't be read or isn't a 32 bits little endian ELF
+*/
+int elf_strings_load(elf_strings_t *elf, const char *path);
+
+/**
+* Give the string stored at an address, log_decoder_lookup_t with the elf_strings_t as context
+* @param address : address on the target
+* @param context : elf_strings_t
+* @return string, NULL when the address isn't in a loaded section or the string isn't terminated
+*/
+const char *elf_strings_lookup(uint32_t address, void *context);
+
+/**
+* Release a firmware
+* @param elf
+* @return none
+*/
+void elf_strings_free(elf_strings_t *elf);
+
+#endif /* ELF_STRINGS_H_ */
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "log_decoder.h"
+
+// Offsets of the fields in a record
+#define LOG_DECODER_LENGTH		2
+#define LOG_DECODER_LEVEL		3
+#define LOG_DECODER_LINE		4
+#define LOG_DECODER_TIMESTAMP	6
+#define LOG_DECODER_FMT			10
+#define LOG_DECODER_FILE		14
+
+static uint32_t log_decoder_get_le(const uint8_t *buffer, uint8_t size)
+{
+	uint32_t value = 0;
+
+	while(size--) value = (value << 8) | buffer[size];
+	return value;
+}
+
+static void log_decoder_byte(log_decoder_t *d, uint8_t data);
+
+// Record in progress is wrong : its bytes after the first sync are given again to find the next record
+static void log_decoder_resync(log_decoder_t *d)
+{
+	uint8_t bytes[LOGGER_WIRE_MAX_SIZE];
+	uint32_t length = d->length - 1;
+
+	memcpy(bytes, &d->buffer[1], length);
+	d->length = 0;
+	d->errors++;
+	for(uint32_t i = 0; i < length; i++) log_decoder_byte(d, bytes[i]);
+}
+
+static void log_decoder_byte(log_decoder_t *d, uint8_t data)
+{
+	char line[LOG_DECODER_LINE_MAX_LENGTH];
+	uint8_t checksum = 0;
+
+	d->buffer[d->length++] = data;
+	switch(d->length)
+	{
+		case 1:
+			if(data != LOGGER_WIRE_SYNC_0) d->length = 0;
+			return;
+		case 2:
+			if(data != LOGGER_WIRE_SYNC_1) d->length = (data == LOGGER_WIRE_SYNC_0) ? 1 : 0;
+			return;
+		case LOG_DECODER_LENGTH + 1:
+			if(data > LOGGER_RECORD_ARGS_SIZE) log_decoder_resync(d);
+			return;
+		default:
+			break;
+	}
+	if(d->length < (uint32_t)LOGGER_WIRE_SIZE(d->buffer[LOG_DECODER_LENGTH])) return;
+
+	for(uint32_t i = 2; i < d->length - 1; i++) checksum ^= d->buffer[i];
+	if(checksum != d->buffer[d->length - 1])
+	{
+		log_decoder_resync(d);
+		return;
+	}
+
+	log_decoder_format(d, d->buffer, line, sizeof(line));
+	d->length = 0;
+	d->records++;
+	if(d->output != NULL) d->output(line, d->context);
+}
+
+void log_decoder_init(log_decoder_t *d, log_decoder_lookup_t lookup, log_decoder_output_t output, void *context)
+{
+	memset(d, 0, sizeof(*d));
+	d->lookup = lookup;
+	d->output = output;
+	d->context = context;
+}
+
+void log_decoder_push(log_decoder_t *d, const uint8_t *data, uint32_t length)
+{
+	while(length--) log_decoder_byte(d, *data++);
+}
+
+int log_decoder_format(log_decoder_t *d, const uint8_t *record, char *line, size_t size)
+{
+	uint8_t level = record[LOG_DECODER_LEVEL];
+	uint32_t timestamp = log_decoder_get_le(&record[LOG_DECODER_TIMESTAMP], 4);
+	uint32_t fmt_address = log_decoder_get_le(&record[LOG_DECODER_FMT], 4);
+	uint32_t file_address = log_decoder_get_le(&record[LOG_DECODER_FILE], 4);
+	const uint8_t *args = &record[LOGGER_WIRE_HEADER_SIZE];
+	const char *fmt;
+	const char *file;
+	int length;
+
+	// Records written by an interrupt may come slightly before the one it has interrupted : the difference is signed
+	if(d->started) d->timestamp += (int64_t)(int32_t)(timestamp - d->last_timestamp);
+	else d->timestamp = timestamp;
+	d->last_timestamp = timestamp;
+	d->started = 1;
+
+	file = (d->lookup != NULL && file_address != 0) ? d->lookup(file_address, d->context) : NULL;
+	length = snprintf(line, size, "%lu.%06lu %-5s %s:%u: ", (unsigned long)(d->timestamp / 1000000), (unsigned long)(d->timestamp % 1000000),
+		logger_level_name(level & ~LOGGER_WIRE_TRUNCATED), (file != NULL) ? file : "?", (unsigned)log_decoder_get_le(&record[LOG_DECODER_LINE], 2));
+	if(length < 0 || (size_t)length >= size) return (size != 0) ? (int)strlen(line) : 0;
+
+	if(fmt_address == 0)
+	{
+		return length + snprintf(&line[length], size - length, "%lu log records dropped", (unsigned long)log_decoder_get_le(args, 4));
+	}
+	fmt = (d->lookup != NULL) ? d->lookup(fmt_address, d->context) : NULL;
+	if(fmt == NULL)
+	{
+		// Firmware doesn't match the capture
+		return length + snprintf(&line[length], size - length, "unknown format 0x%08lx", (unsigned long)fmt_address);
+	}
+
+	return length + logger_format_args(&line[length], size - length, fmt, args, record[LOG_DECODER_LENGTH], level & LOGGER_WIRE_TRUNCATED);
+}
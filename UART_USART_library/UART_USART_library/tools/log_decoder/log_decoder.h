@@ -0,0 +1,80 @@
+/*
+							        *******************
+******************************* C HEADER FILE *******************************
+**                           *******************                           **
+**                                                                         **
+** project   : RAPTORS                                                     **
+** filename  : log_decoder                                                 **
+** date      : January 11, 2019                                            **
+** author    : Julien Delvaux                                              **
+** licence   : MIT                                                         **
+**                                                                         **
+*****************************************************************************
+Host side of LOGGER_BINARY_OUTPUT : binary records (logger_format.h) are turned back into
+the lines log_log would have written, format and file strings are read from the firmware.
+
+ - Bytes are given as they come (capture, serial port), a record may be split anywhere
+ - A corrupted record is skipped : the decoder looks for the next sync from its second byte
+ - 32 bits timestamps of the firmware are extended, lines give seconds since boot
+
+*/
+
+#ifndef LOG_DECODER_H_
+#define LOG_DECODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "logger_format.h"
+
+// Longest line given to the output
+#define LOG_DECODER_LINE_MAX_LENGTH	256
+
+// Give the string stored at an address of the firmware, NULL when it is unknown
+typedef const char *(*log_decoder_lookup_t)(uint32_t address, void *context);
+// Receive a decoded line, without end of line
+typedef void (*log_decoder_output_t)(const char *line, void *context);
+
+typedef struct {
+	uint8_t buffer[LOGGER_WIRE_MAX_SIZE];
+	uint32_t length;				// bytes of the record in progress
+	log_decoder_lookup_t lookup;
+	log_decoder_output_t output;
+	void *context;					// given to lookup and output
+	uint64_t timestamp;				// extended timestamp of the last record, in microseconds
+	uint32_t last_timestamp;		// timestamp of the last record as sent by the firmware
+	uint8_t started;
+	uint32_t records;				// records decoded
+	uint32_t errors;				// records skipped on a wrong checksum or length
+} log_decoder_t;
+
+/**
+* Initialize the decoder
+* @param d
+* @param lookup : strings of the firmware
+* @param output : decoded lines
+* @param context : given to lookup and output
+* @return none
+*/
+void log_decoder_init(log_decoder_t *d, log_decoder_lookup_t lookup, log_decoder_output_t output, void *context);
+
+/**
+* Give received bytes to the decoder, output is called for each record completed by them
+* @param d
+* @param data
+* @param length
+* @return none
+*/
+void log_decoder_push(log_decoder_t *d, const uint8_t *data, uint32_t length);
+
+/**
+* Format one record as logger_format_record does, with the extended timestamp
+* @param d
+* @param record : LOGGER_WIRE_SIZE bytes of the record, checksum already checked
+* @param line : text, always terminated
+* @param size : size of line
+* @return length of the text in line
+*/
+int log_decoder_format(log_decoder_t *d, const uint8_t *record, char *line, size_t size);
+
+#endif /* LOG_DECODER_H_ */
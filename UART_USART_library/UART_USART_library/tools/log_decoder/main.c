@@ -0,0 +1,80 @@
+/*
+Decoder of the binary logs written with LOGGER_BINARY_OUTPUT
+
+Usage : log_decoder firmware.elf [capture | serial port | -]
+	firmware.elf : firmware running on the target, the one which has written the logs
+	capture : bytes saved from the log port, standard input with '-' or without argument
+	serial port : /dev/ttyACM0, ... put in raw mode, its speed is kept (stty -F /dev/ttyACM0 115200)
+
+Build on a Linux host (elf.h, termios) from UART_USART_library/UART_USART_library :
+	gcc -O2 -Wall -Isrc/lib -Itools/log_decoder -o log_decoder tools/log_decoder/main.c tools/log_decoder/log_decoder.c tools/log_decoder/elf_strings.c src/lib/logger_format.c
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "elf_strings.h"
+#include "log_decoder.h"
+
+static void print_line(const char *line, void *context)
+{
+	(void)context;
+	printf("%s\n", line);
+}
+
+int main(int argc, char *argv[])
+{
+	elf_strings_t elf;
+	log_decoder_t decoder;
+	uint8_t bytes[256];
+	ssize_t length;
+	int fd = STDIN_FILENO;
+
+	if(argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "usage: %s firmware.elf [capture | serial port | -]\n", argv[0]);
+		return 2;
+	}
+	if(elf_strings_load(&elf, argv[1]) != 0)
+	{
+		fprintf(stderr, "%s: not a 32 bits little endian ELF\n", argv[1]);
+		return 1;
+	}
+	if(argc == 3 && strcmp(argv[2], "-") != 0)
+	{
+		fd = open(argv[2], O_RDONLY | O_NOCTTY);
+		if(fd < 0)
+		{
+			perror(argv[2]);
+			elf_strings_free(&elf);
+			return 1;
+		}
+	}
+	if(isatty(fd))
+	{
+		struct termios tty;
+
+		// Records are binary : no translation nor line buffering
+		if(tcgetattr(fd, &tty) == 0)
+		{
+			cfmakeraw(&tty);
+			tcsetattr(fd, TCSANOW, &tty);
+		}
+	}
+
+	log_decoder_init(&decoder, elf_strings_lookup, print_line, &elf);
+	while((length = read(fd, bytes, sizeof(bytes))) > 0)
+	{
+		log_decoder_push(&decoder, bytes, (uint32_t)length);
+		fflush(stdout);
+	}
+
+	fprintf(stderr, "%lu records, %lu errors\n", (unsigned long)decoder.records, (unsigned long)decoder.errors);
+	if(fd != STDIN_FILENO) close(fd);
+	elf_strings_free(&elf);
+
+	return 0;
+}